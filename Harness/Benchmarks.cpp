@@ -0,0 +1,269 @@
+/*
+  ==============================================================================
+
+    File: benchmarks.cpp
+    Author: Daniel Schwartz
+    Description: Measures the cost of the plugin processor.
+
+  ==============================================================================
+*/
+
+#include "Clock.h"
+#include "ProcessorHarness.h"
+
+using namespace clockmaker_harness;
+
+namespace
+{
+    // The seconds of audio rendered for each measurement
+    constexpr double benchmarkSeconds = 2.0;
+
+    // Somewhere to write rendered output so it is not optimised away
+    volatile float benchmarkSink = 0.f;
+
+    // The time taken by a function in nanoseconds
+    template <typename Function>
+    double timeNanoseconds (Function&& function)
+    {
+        auto start = juce::Time::getHighResolutionTicks();
+        function();
+        auto ticks = juce::Time::getHighResolutionTicks() - start;
+        return juce::Time::highResolutionTicksToSeconds (ticks) * 1.0e9;
+    }
+
+    // The cost of a playing processor in nanoseconds per sample
+    template <typename SampleType>
+    double benchmarkProcessor (ProcessorHarness& harness)
+    {
+        harness.playHead.setTempo (120.0);
+        harness.playHead.setPlaying (true);
+
+        auto buffer = harness.makeBuffer<SampleType>();
+        juce::MidiBuffer midi;
+        int numBlocks = static_cast<int> (benchmarkSeconds * harness.sampleRate / harness.blockSize);
+
+        // Settle the parameters and transport before timing
+        for (int block = 0; block < 16; ++block)
+            harness.render (buffer, midi);
+
+        auto elapsed = timeNanoseconds ([&]
+        {
+            for (int block = 0; block < numBlocks; ++block)
+                harness.render (buffer, midi);
+        });
+
+        return elapsed / (static_cast<double> (numBlocks) * harness.blockSize);
+    }
+
+    // The original clock, which stepped a float phase in radians one sample at
+    // a time and was resynced by the number of samples played.  It is kept here
+    // as the baseline for rendering from the edge schedule.
+    class PerSampleClock
+    {
+    public:
+        PerSampleClock (double sampleRate, double bpm, int ppqn)
+            : delta (juce::MathConstants<float>::twoPi * static_cast<float> (bpm * ppqn / 60.0) / static_cast<float> (sampleRate))
+        {
+        }
+
+        void setTimeAdvance (int numSamples)
+        {
+            phase = std::fmod (delta * static_cast<float> (numSamples), juce::MathConstants<float>::twoPi);
+        }
+
+        float process()
+        {
+            float sample = phase < juce::MathConstants<float>::pi ? 1.f : -1.f;
+            phase += delta;
+
+            if (phase > juce::MathConstants<float>::twoPi)
+                phase -= juce::MathConstants<float>::twoPi;
+
+            return sample;
+        }
+
+    private:
+        float phase = 0.f;
+        float delta;
+    };
+
+    // The cost of a clock in nanoseconds per sample, resynced to the timeline
+    // every block, rendered by the clock or by the original per-sample clock
+    double benchmarkClock (double sampleRate, int blockSize, int ppqn, bool perSample)
+    {
+        dingus_dsp::Clock clock;
+        clock.Init (sampleRate);
+        clock.SetPpqn (ppqn);
+        clock.SetMulDiv (1);
+
+        PerSampleClock baseline (sampleRate, 120.0, ppqn);
+
+        std::vector<float> block (static_cast<size_t> (blockSize));
+        int numBlocks = static_cast<int> (benchmarkSeconds * sampleRate / blockSize);
+        float sum = 0.f;
+
+        auto elapsed = timeNanoseconds ([&]
+        {
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                if (perSample)
+                {
+                    baseline.setTimeAdvance (i * blockSize);
+
+                    for (auto& sample : block)
+                        sample = baseline.process();
+                }
+                else
+                {
+                    clock.SetTempo (120.0);
+                    clock.SetPpqPosition (i * blockSize * 2.0 / sampleRate, 0.0);
+                    clock.ProcessBlock (block.data(), blockSize);
+                }
+
+                sum += block.back();
+            }
+        });
+
+        // Keep the output so the rendering cannot be optimised away
+        benchmarkSink = sum;
+        return elapsed / (static_cast<double> (numBlocks) * blockSize);
+    }
+}
+
+//==============================================================================
+class ClockBenchmark : public juce::UnitTest
+{
+public:
+    ClockBenchmark() : juce::UnitTest ("Clock", "Benchmark") {}
+
+    void runTest() override
+    {
+        beginTest ("Block rendering against the original per-sample clock");
+
+        for (int blockSize : { 32, 128, 512 })
+        {
+            for (int ppqn : { 24, 96 })
+            {
+                auto blockNs = benchmarkClock (192000.0, blockSize, ppqn, false);
+                auto sampleNs = benchmarkClock (192000.0, blockSize, ppqn, true);
+
+                // The clock resyncs from the host position and finds its edges once per
+                // block, so small blocks can cost more than the original clock
+                logMessage ("192000 Hz, " + juce::String (blockSize) + " samples, " + juce::String (ppqn) + " PPQN: "
+                            + juce::String (blockNs, 2) + " ns/sample by block, "
+                            + juce::String (sampleNs, 2) + " ns/sample for the original clock, "
+                            + juce::String (sampleNs / blockNs, 2) + "x");
+            }
+        }
+    }
+};
+
+static ClockBenchmark clockBenchmark;
+
+//==============================================================================
+class ProcessorBenchmark : public juce::UnitTest
+{
+public:
+    ProcessorBenchmark() : juce::UnitTest ("Processor", "Benchmark") {}
+
+    void runTest() override
+    {
+        beginTest ("Processor cost per sample");
+
+        for (double sampleRate : { 44100.0, 96000.0, 192000.0 })
+        {
+            for (int blockSize : { 32, 128, 512 })
+            {
+                for (int ppqn : { 4, 24, 96 })
+                {
+                    for (int numChannels : { 1, 2, 8 })
+                    {
+                        // Each setting is measured at both precisions, from a fresh processor
+                        ProcessorHarness floatHarness (sampleRate, blockSize, numChannels);
+                        floatHarness.setParameter ("ppqn", static_cast<float> (ppqn));
+                        auto floatNs = benchmarkProcessor<float> (floatHarness);
+
+                        ProcessorHarness doubleHarness (sampleRate, blockSize, numChannels);
+                        doubleHarness.setParameter ("ppqn", static_cast<float> (ppqn));
+                        doubleHarness.setDoublePrecision();
+                        auto doubleNs = benchmarkProcessor<double> (doubleHarness);
+
+                        logMessage (juce::String (sampleRate, 0) + " Hz, " + juce::String (blockSize) + " samples, "
+                                    + juce::String (ppqn) + " PPQN, " + juce::String (numChannels) + " channels: "
+                                    + juce::String (floatNs, 2) + " ns/sample float, "
+                                    + juce::String (doubleNs, 2) + " ns/sample double");
+                        logMessage ("    " + floatHarness.processor.getTelemetry().GetSnapshot().ToString());
+                    }
+                }
+            }
+        }
+    }
+};
+
+static ProcessorBenchmark processorBenchmark;
+
+//==============================================================================
+class StateBenchmark : public juce::UnitTest
+{
+public:
+    StateBenchmark() : juce::UnitTest ("State", "Benchmark") {}
+
+    void runTest() override
+    {
+        beginTest ("Saving and loading the state of one instance");
+
+        const int repeats = 1000;
+        ProcessorHarness harness (48000.0, 512);
+        harness.setParameter ("ppqn", 48.f);
+
+        juce::MemoryBlock binaryState;
+        harness.processor.getStateInformation (binaryState);
+
+        // The XML state that earlier versions wrote for the same parameter tree,
+        // which follows the 8 byte tag and version in the binary state
+        auto tree = juce::ValueTree::readFromData (static_cast<const char*> (binaryState.getData()) + 8, binaryState.getSize() - 8);
+        juce::MemoryBlock xmlState;
+        juce::AudioProcessor::copyXmlToBinary (*tree.createXml(), xmlState);
+
+        auto binarySave = timeNanoseconds ([&]
+        {
+            for (int i = 0; i < repeats; ++i)
+            {
+                juce::MemoryBlock state;
+                harness.processor.getStateInformation (state);
+            }
+        });
+
+        auto xmlSave = timeNanoseconds ([&]
+        {
+            for (int i = 0; i < repeats; ++i)
+            {
+                juce::MemoryBlock state;
+                juce::AudioProcessor::copyXmlToBinary (*tree.createXml(), state);
+            }
+        });
+
+        auto binaryLoad = timeNanoseconds ([&]
+        {
+            for (int i = 0; i < repeats; ++i)
+                harness.processor.setStateInformation (binaryState.getData(), static_cast<int> (binaryState.getSize()));
+        });
+
+        auto xmlLoad = timeNanoseconds ([&]
+        {
+            for (int i = 0; i < repeats; ++i)
+                harness.processor.setStateInformation (xmlState.getData(), static_cast<int> (xmlState.getSize()));
+        });
+
+        logMessage ("Binary: " + juce::String (binaryState.getSize()) + " bytes, save "
+                    + juce::String (binarySave / repeats * 1.0e-3, 2) + " us, load "
+                    + juce::String (binaryLoad / repeats * 1.0e-3, 2) + " us per instance");
+        logMessage ("XML: " + juce::String (xmlState.getSize()) + " bytes, save "
+                    + juce::String (xmlSave / repeats * 1.0e-3, 2) + " us, load "
+                    + juce::String (xmlLoad / repeats * 1.0e-3, 2) + " us per instance");
+
+        expectEquals (harness.getParameter ("ppqn"), 48.f, "Both formats load");
+    }
+};
+
+static StateBenchmark stateBenchmark;
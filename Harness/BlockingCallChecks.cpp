@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    File: blockingcallchecks.cpp
+    Author: Daniel Schwartz
+    Description: Counts locks, waits, sleeps and file I/O in the audio callback.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "RealtimeCheck.h"
+
+#if CLOCKMAKER_REALTIME_CHECKS && JUCE_LINUX
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+
+//==============================================================================
+// The harness defines these calls itself, so every use in the process comes
+// here first.  Each reports a violation if the current thread is running the
+// audio callback, then calls the C library's own version.  Only the blocking
+// forms are checked, so try-locks and unlocks pass straight through.  Reads
+// are left out as the C library may inline them when fortified.
+namespace
+{
+    // The next definition of a function after this one, looked up on first use
+    template <typename Function>
+    Function findNext (std::atomic<void*>& next, const char* name)
+    {
+        void* function = next.load (std::memory_order_relaxed);
+
+        if (function == nullptr)
+        {
+            function = dlsym (RTLD_NEXT, name);
+            next.store (function, std::memory_order_relaxed);
+        }
+
+        return reinterpret_cast<Function> (function);
+    }
+}
+
+#define CLOCKMAKER_BLOCKING_CALL(returnType, name, parameters, arguments, ...) \
+    extern "C" returnType name parameters __VA_ARGS__ \
+    { \
+        static std::atomic<void*> next { nullptr }; \
+        dingus_dsp::RealtimeCheck::AssertNotRealtime(); \
+        return findNext<returnType (*) parameters> (next, #name) arguments; \
+    }
+
+CLOCKMAKER_BLOCKING_CALL (int, pthread_mutex_lock, (pthread_mutex_t* mutex), (mutex), noexcept)
+CLOCKMAKER_BLOCKING_CALL (int, pthread_rwlock_rdlock, (pthread_rwlock_t* lock), (lock), noexcept)
+CLOCKMAKER_BLOCKING_CALL (int, pthread_rwlock_wrlock, (pthread_rwlock_t* lock), (lock), noexcept)
+CLOCKMAKER_BLOCKING_CALL (int, pthread_cond_wait, (pthread_cond_t* condition, pthread_mutex_t* mutex), (condition, mutex))
+CLOCKMAKER_BLOCKING_CALL (int, pthread_cond_timedwait, (pthread_cond_t* condition, pthread_mutex_t* mutex, const timespec* time), (condition, mutex, time))
+CLOCKMAKER_BLOCKING_CALL (int, pthread_join, (pthread_t thread, void** result), (thread, result))
+CLOCKMAKER_BLOCKING_CALL (int, sem_wait, (sem_t* semaphore), (semaphore))
+CLOCKMAKER_BLOCKING_CALL (int, nanosleep, (const timespec* duration, timespec* remaining), (duration, remaining))
+CLOCKMAKER_BLOCKING_CALL (int, clock_nanosleep, (clockid_t clock, int flags, const timespec* duration, timespec* remaining), (clock, flags, duration, remaining))
+CLOCKMAKER_BLOCKING_CALL (int, usleep, (useconds_t microseconds), (microseconds))
+CLOCKMAKER_BLOCKING_CALL (unsigned int, sleep, (unsigned int seconds), (seconds))
+CLOCKMAKER_BLOCKING_CALL (ssize_t, write, (int file, const void* data, size_t size), (file, data, size))
+CLOCKMAKER_BLOCKING_CALL (int, fsync, (int file), (file))
+
+#undef CLOCKMAKER_BLOCKING_CALL
+
+#endif
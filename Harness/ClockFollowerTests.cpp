@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    File: clockfollowertests.cpp
+    Author: Daniel Schwartz
+    Description: Measures how well the clock follower locks to a jittery input.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ClockFollower.h"
+
+using namespace dingus_dsp;
+
+namespace
+{
+    // How an input clock is sent to the follower and how much it jitters
+    struct FollowerSetting
+    {
+        const char* name;
+        bool isAudio;
+        double jitterSamples;
+        double loopGain;
+        double lockTolerance;
+    };
+
+    // The measured performance of the follower
+    struct FollowerResult
+    {
+        bool locked;
+        double lockPulses;
+        double inputJitter;
+        double tempoError;
+        double outputJitter;
+        double maxOutputError;
+    };
+}
+
+//==============================================================================
+class ClockFollowerTests : public juce::UnitTest
+{
+public:
+    ClockFollowerTests() : juce::UnitTest ("Clock Follower", "Clockmaker") {}
+
+    void runTest() override
+    {
+        beginTest ("Locks to a jittery audio clock");
+        {
+            auto result = follow ({ "Audio clock", true, 2.0, 0.25, 0.05 });
+            expect (result.locked, "Locked");
+            expectLessThan (result.lockPulses, 16.0, "Pulses to lock");
+            expectLessThan (result.tempoError, 0.1, "Tempo error");
+            expectLessThan (result.maxOutputError, 3.0, "Output error in samples");
+        }
+
+        beginTest ("Locks to jittery MIDI clock");
+        {
+            // One millisecond of jitter either way, smoothed as the processor does
+            auto result = follow ({ "MIDI clock", false, 48.0, 0.1, 0.15 });
+            expect (result.locked, "Locked");
+            expectLessThan (result.lockPulses, 48.0, "Pulses to lock");
+            expectLessThan (result.tempoError, 1.0, "Tempo error");
+            expectLessThan (result.maxOutputError, 48.0, "Output error in samples");
+        }
+    }
+
+private:
+    // Follow a minute of a 24 PPQN clock at 120 BPM and 48 kHz, a pulse every
+    // 1000 samples, with every edge moved by up to jitterSamples either way.
+    // The first edge is quarter note zero, so its jitter offsets the followed
+    // position for good.  The output jitter is measured around that offset,
+    // once the loop has had a few seconds to settle.
+    FollowerResult follow (const FollowerSetting& setting)
+    {
+        const double sampleRate = 48000.0;
+        const double period = 1000.0;
+        const double firstEdge = 100.0;
+        const int ppqn = 24;
+        const int blockSize = 256;
+        const double settleSeconds = 4.0;
+
+        ClockFollower follower;
+        follower.Init (sampleRate);
+        follower.SetPpqn (ppqn);
+        follower.SetThreshold (0.25f, 0.05f);
+        follower.SetLoopGain (setting.loopGain, setting.lockTolerance);
+
+        juce::Random random (1234);
+        std::vector<float> block (static_cast<size_t> (blockSize));
+        juce::int64 pulse = 0;
+        juce::int64 highUntil = 0;
+        juce::Array<double> positionErrors;
+        int numBlocks = static_cast<int> (60.0 * sampleRate / blockSize);
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            juce::int64 blockStart = static_cast<juce::int64> (i) * blockSize;
+            juce::int64 blockEnd = blockStart + blockSize;
+
+            // Carry on the high part of a pulse from the previous block
+            std::fill (block.begin(), block.end(), 0.f);
+            std::fill (block.begin(), block.begin() + juce::jlimit (0, blockSize, static_cast<int> (highUntil - blockStart)), 1.f);
+
+            if (! setting.isAudio)
+                follower.StartBlock (blockSize);
+
+            // Every pulse due in the block, moved by the jitter and high for half a period
+            while (firstEdge + pulse * period < blockEnd)
+            {
+                double edge = firstEdge + pulse * period + (2.0 * random.nextDouble() - 1.0) * setting.jitterSamples;
+                auto start = juce::jlimit (blockStart, blockEnd - 1, static_cast<juce::int64> (std::ceil (edge)));
+                highUntil = start + static_cast<juce::int64> (period / 2);
+
+                if (setting.isAudio)
+                    std::fill (block.begin() + (start - blockStart), block.begin() + juce::jmin (blockEnd, highUntil) - blockStart, 1.f);
+                else
+                    follower.AddEdge (static_cast<double> (start - blockStart));
+
+                ++pulse;
+            }
+
+            if (setting.isAudio)
+                follower.ProcessBlock (block.data(), blockSize);
+            else
+                follower.EndBlock();
+
+            // Compare the followed position with the true one
+            if (blockStart >= settleSeconds * sampleRate)
+            {
+                double truePosition = (blockStart - firstEdge) / (period * ppqn);
+                positionErrors.add ((follower.GetPpqPosition (0) - truePosition) * period * ppqn);
+            }
+        }
+
+        double offset = 0.0;
+
+        for (auto error : positionErrors)
+            offset += error / positionErrors.size();
+
+        double meanSquare = 0.0;
+        double maxOutputError = 0.0;
+
+        for (auto error : positionErrors)
+        {
+            meanSquare += (error - offset) * (error - offset) / positionErrors.size();
+            maxOutputError = juce::jmax (maxOutputError, std::abs (error - offset));
+        }
+
+        FollowerResult result;
+        result.locked = follower.IsLocked();
+        result.lockPulses = follower.GetLockTime() / period;
+        result.inputJitter = follower.GetJitter();
+        result.tempoError = std::abs (follower.GetTempo() - 120.0);
+        result.outputJitter = std::sqrt (meanSquare);
+        result.maxOutputError = maxOutputError;
+
+        logMessage (juce::String (setting.name) + ": locked after " + juce::String (result.lockPulses, 1) + " pulses, input jitter "
+                    + juce::String (result.inputJitter, 2) + " samples RMS, tempo error " + juce::String (result.tempoError, 4)
+                    + " BPM, output jitter " + juce::String (result.outputJitter, 2) + " samples RMS, "
+                    + juce::String (result.maxOutputError, 2) + " at most");
+
+        return result;
+    }
+};
+
+static ClockFollowerTests clockFollowerTests;
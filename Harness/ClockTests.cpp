@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    File: clocktests.cpp
+    Author: Daniel Schwartz
+    Description: Tests the clock engine on its own.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "Clock.h"
+
+using namespace dingus_dsp;
+
+namespace
+{
+    // A clock setting with a whole number tempo and sample rate, so the exact
+    // time of every pulse is a ratio of integers
+    struct ClockSetting
+    {
+        int sampleRate;
+        int bpm;
+        int ppqn;
+        int mulDiv;
+        int blockSize;
+        double hours;
+    };
+}
+
+//==============================================================================
+class ClockTests : public juce::UnitTest
+{
+public:
+    ClockTests() : juce::UnitTest ("Clock", "Clockmaker") {}
+
+    void runTest() override
+    {
+        beginTest ("Long runs place every edge on the correct sample");
+        {
+            const ClockSetting settings[] = {
+                { 48000, 120, 24, 1, 512, 3.0 },
+                { 44100, 133, 96, 3, 64, 2.0 },
+                { 96000, 97, 24, -3, 256, 2.0 },
+                { 192000, 174, 4, 1, 32, 1.0 }
+            };
+
+            for (auto& setting : settings)
+                checkLongRun (setting);
+        }
+    }
+
+private:
+    // Play the clock for hours, resyncing it from the host position at the
+    // start of every block as the processor does, and compare every rising
+    // edge with its exact time
+    void checkLongRun (const ClockSetting& setting)
+    {
+        Telemetry telemetry;
+        Clock clock;
+        clock.Init (setting.sampleRate);
+        clock.SetTelemetry (&telemetry);
+        clock.SetPpqn (setting.ppqn);
+        clock.SetMulDiv (setting.mulDiv);
+
+        // Pulse k starts at exactly k * period / ratio samples
+        juce::int64 mul = juce::jmax (1, setting.mulDiv);
+        juce::int64 div = setting.mulDiv < -1 ? -setting.mulDiv : 1;
+        juce::int64 period = 60LL * setting.sampleRate * div;
+        juce::int64 ratio = static_cast<juce::int64> (setting.bpm) * setting.ppqn * mul;
+
+        std::array<Clock::Edge, 64> edges;
+        juce::int64 totalSamples = static_cast<juce::int64> (setting.hours * 3600.0 * setting.sampleRate);
+        juce::int64 pulse = 0;
+        juce::int64 wrongSamples = 0;
+        juce::int64 numEdges = 0;
+        juce::int64 wrongErrors = 0;
+        double maxError = 0.0;
+
+        for (juce::int64 blockStart = 0; blockStart < totalSamples; blockStart += setting.blockSize)
+        {
+            clock.SetTempo (setting.bpm);
+            clock.SetPpqPosition (blockStart * static_cast<double> (setting.bpm) / (60.0 * setting.sampleRate), 0.0);
+            int count = clock.ProcessEdges (edges.data(), static_cast<int> (edges.size()), setting.blockSize);
+            numEdges += count;
+
+            for (size_t i = 0; i < static_cast<size_t> (count); ++i)
+            {
+                if (! edges[i].rising)
+                    continue;
+
+                // The first sample at or after the exact edge time
+                juce::int64 expected = (pulse * period + ratio - 1) / ratio;
+                juce::int64 rendered = blockStart + edges[i].offset;
+                double exact = static_cast<double> (pulse * period) / ratio;
+
+                if (rendered != expected)
+                    ++wrongSamples;
+
+                if (std::abs (edges[i].error - (rendered - exact)) > 1.0e-6)
+                    ++wrongErrors;
+
+                maxError = juce::jmax (maxError, std::abs (rendered - exact));
+                ++pulse;
+            }
+        }
+
+        juce::String description = juce::String (setting.sampleRate) + " Hz, " + juce::String (setting.bpm) + " BPM, "
+                           + juce::String (setting.ppqn) + " PPQN, mul/div " + juce::String (setting.mulDiv);
+
+        logMessage (description + ": " + juce::String (pulse) + " pulses over " + juce::String (setting.hours, 1)
+                    + " hours, max edge error " + juce::String (maxError, 6) + " samples");
+
+        expectEquals (pulse, ((totalSamples - 1) * ratio) / period + 1, description + " pulse count");
+        expectEquals (wrongSamples, static_cast<juce::int64> (0), description + " edges on the wrong sample");
+        expectLessThan (maxError, 1.0, description + " max edge error");
+        expectEquals (wrongErrors, static_cast<juce::int64> (0), description + " edges with the wrong reported error");
+        expectEquals (static_cast<juce::int64> (telemetry.GetSnapshot().edge_error.GetTotal()), numEdges, description + " edge errors recorded");
+    }
+};
+
+static ClockTests clockTests;
@@ -0,0 +1,32 @@
+/*
+  ==============================================================================
+
+    File: main.cpp
+    Author: Daniel Schwartz
+    Description: Runs the offline tests or benchmarks for the plugin.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// ClockmakerHarness --test       runs the tests, which is the default
+// ClockmakerHarness --benchmark  runs the benchmarks and prints their results
+int main (int argc, char* argv[])
+{
+    // The processor posts latency changes to the message thread, so it needs one to exist
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure (false);
+    runner.runTestsInCategory (args.containsOption ("--benchmark") ? "Benchmark" : "Clockmaker");
+
+    int failures = 0;
+
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult (i)->failures;
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    File: processorharness.cpp
+    Author: Daniel Schwartz
+    Description: Runs the plugin processor offline from a scripted playhead.
+
+  ==============================================================================
+*/
+
+#include "ProcessorHarness.h"
+
+using namespace clockmaker_harness;
+
+ProcessorHarness::ProcessorHarness (double sampleRate_, int blockSize_, int numChannels, bool allOutputs)
+    : sampleRate (sampleRate_), blockSize (blockSize_)
+{
+    auto layout = processor.getBusesLayout();
+    auto channels = juce::AudioChannelSet::discreteChannels (numChannels);
+
+    if (numChannels == 1)
+        channels = juce::AudioChannelSet::mono();
+    else if (numChannels == 2)
+        channels = juce::AudioChannelSet::stereo();
+
+    layout.inputBuses.getReference (0) = channels;
+    layout.outputBuses.getReference (0) = channels;
+
+    if (allOutputs)
+    {
+        for (int bus = 1; bus < layout.outputBuses.size(); ++bus)
+            layout.outputBuses.getReference (bus) = juce::AudioChannelSet::mono();
+    }
+
+    processor.setBusesLayout (layout);
+    processor.setPlayHead (&playHead);
+    playHead.setSampleRate (sampleRate);
+    prepare();
+}
+
+ProcessorHarness::~ProcessorHarness()
+{
+    processor.releaseResources();
+    processor.setPlayHead (nullptr);
+}
+
+void ProcessorHarness::prepare()
+{
+    processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+}
+
+juce::RangedAudioParameter* ProcessorHarness::findParameter (const juce::String& parameterId) const
+{
+    for (auto* parameter : processor.getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            if (ranged->paramID == parameterId)
+                return ranged;
+    }
+
+    return nullptr;
+}
+
+void ProcessorHarness::setParameter (const juce::String& parameterId, float value)
+{
+    auto* parameter = findParameter (parameterId);
+    jassert (parameter != nullptr);
+
+    parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+}
+
+float ProcessorHarness::getParameter (const juce::String& parameterId) const
+{
+    auto* parameter = findParameter (parameterId);
+    jassert (parameter != nullptr);
+
+    return parameter->convertFrom0to1 (parameter->getValue());
+}
+
+void ProcessorHarness::setDoublePrecision()
+{
+    processor.releaseResources();
+    processor.setProcessingPrecision (juce::AudioProcessor::doublePrecision);
+    prepare();
+}
+
+template <typename SampleType>
+void ProcessorHarness::render (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midi, bool bypassed)
+{
+    if (bypassed)
+        processor.processBlockBypassed (buffer, midi);
+    else
+        processor.processBlock (buffer, midi);
+
+    playHead.advance (buffer.getNumSamples());
+}
+
+template void ProcessorHarness::render<float> (juce::AudioBuffer<float>&, juce::MidiBuffer&, bool);
+template void ProcessorHarness::render<double> (juce::AudioBuffer<double>&, juce::MidiBuffer&, bool);
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    File: processorharness.h
+    Author: Daniel Schwartz
+    Description: Runs the plugin processor offline from a scripted playhead.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "ScriptedPlayHead.h"
+
+namespace clockmaker_harness
+{
+    // Runs the plugin processor offline from a scripted playhead.
+    // The processor is set up as a host would, with numChannels on the main
+    // input and output, and optionally every other output bus enabled.
+    class ProcessorHarness
+    {
+    public:
+        ProcessorHarness (double sampleRate, int blockSize, int numChannels = 1, bool allOutputs = false);
+        ~ProcessorHarness();
+
+        // Set a parameter to a plain value, as if from the host
+        void setParameter (const juce::String& parameterId, float value);
+
+        // The plain value of a parameter
+        float getParameter (const juce::String& parameterId) const;
+
+        // Switch the processor to 64-bit processing
+        void setDoublePrecision();
+
+        // A buffer with enough channels for every enabled bus
+        template <typename SampleType>
+        juce::AudioBuffer<SampleType> makeBuffer() const
+        {
+            return juce::AudioBuffer<SampleType> (juce::jmax (processor.getTotalNumInputChannels(),
+                                                              processor.getTotalNumOutputChannels()), blockSize);
+        }
+
+        // Render a block at the playhead, then move the playhead on
+        template <typename SampleType>
+        void render (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midi, bool bypassed = false);
+
+        // The first channel of an output bus in a rendered block
+        template <typename SampleType>
+        const SampleType* getOutput (juce::AudioBuffer<SampleType>& buffer, int bus)
+        {
+            return processor.getBusBuffer (buffer, false, bus).getReadPointer (0);
+        }
+
+        const double sampleRate;
+        const int blockSize;
+
+        ScriptedPlayHead playHead;
+        ClockmakerAudioProcessor processor;
+
+    private:
+        void prepare();
+
+        // The parameter with an ID, or nullptr
+        juce::RangedAudioParameter* findParameter (const juce::String& parameterId) const;
+
+        JUCE_DECLARE_NON_COPYABLE (ProcessorHarness)
+    };
+}
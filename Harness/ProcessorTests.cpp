@@ -0,0 +1,607 @@
+/*
+  ==============================================================================
+
+    File: processortests.cpp
+    Author: Daniel Schwartz
+    Description: Tests the plugin processor against a scripted playhead.
+
+  ==============================================================================
+*/
+
+#include "ProcessorHarness.h"
+
+using namespace clockmaker_harness;
+
+namespace
+{
+    // The samples where the output rises above zero, counted from the first block
+    template <typename SampleType>
+    void findRisingEdges (const SampleType* data, int numSamples, juce::int64 blockStart,
+                          SampleType& lastSample, juce::Array<juce::int64>& edges)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            if (data[i] > 0 && lastSample <= 0)
+                edges.add (blockStart + i);
+
+            lastSample = data[i];
+        }
+    }
+
+    // The reset and run outputs follow the four clock outputs
+    const int resetBus = 4;
+    const int runBus = 5;
+
+    // The number of places where two lists of edges differ, including any extra edges
+    int countDifferences (const juce::Array<juce::int64>& edges, const juce::Array<juce::int64>& expected)
+    {
+        int differences = std::abs (edges.size() - expected.size());
+
+        for (int i = 0; i < juce::jmin (edges.size(), expected.size()); ++i)
+            if (edges[i] != expected[i])
+                ++differences;
+
+        return differences;
+    }
+
+    // A parameter and the plain value to set it to
+    struct ParameterValue
+    {
+        const char* parameterId;
+        float value;
+    };
+
+    // A set of parameter values to run the processor with
+    struct ProcessorMode
+    {
+        const char* name;
+        std::vector<ParameterValue> values;
+    };
+
+    // Write a 24 PPQN clock at 120 BPM and 48 kHz to the first input channel,
+    // and MIDI clock ticks at the same times
+    template <typename SampleType>
+    void writeInputClocks (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midi, juce::int64 blockStart)
+    {
+        const juce::int64 period = 1000;
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            auto phase = (blockStart + i) % period;
+            buffer.setSample (0, i, phase < period / 2 ? SampleType (1) : SampleType (0));
+
+            if (phase == 0)
+                midi.addEvent (blockStart + i == 0 ? juce::MidiMessage::midiStart() : juce::MidiMessage::midiClock(), i);
+        }
+    }
+
+    // A MIDI message from the processor and the sample it was sent on, counted from the first block
+    struct SentMessage
+    {
+        juce::int64 sample;
+        juce::MidiMessage message;
+    };
+
+    // Start playback at a position and collect the MIDI the processor sends
+    juce::Array<SentMessage> startMidiClock (ProcessorHarness& harness, double ppqPosition, int numBlocks)
+    {
+        harness.playHead.setTempo (120.0);
+        harness.playHead.setPosition (ppqPosition);
+        harness.playHead.setPlaying (true);
+
+        auto buffer = harness.makeBuffer<float>();
+        juce::MidiBuffer midi;
+        juce::Array<SentMessage> sent;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            midi.clear();
+            harness.render (buffer, midi);
+
+            for (const auto metadata : midi)
+                sent.add ({ static_cast<juce::int64> (block) * buffer.getNumSamples() + metadata.samplePosition, metadata.getMessage() });
+        }
+
+        return sent;
+    }
+
+    // Play, loop, ramp the tempo, stop, start and bypass the processor in turn
+    template <typename SampleType>
+    void runTransportScript (ProcessorHarness& harness)
+    {
+        auto buffer = harness.makeBuffer<SampleType>();
+        juce::MidiBuffer midi;
+
+        harness.playHead.setTempo (120.0);
+        harness.playHead.setLoop (0.0, 1.0);
+        harness.playHead.setPlaying (true);
+
+        for (int block = 0; block < 400; ++block)
+        {
+            if (block == 100)
+                harness.playHead.setLoop (0.0, 0.0);
+            else if (block >= 100 && block < 150)
+                harness.playHead.setTempo (120.0 + (block - 100) * 0.5);
+            else if (block == 200)
+                harness.playHead.setPlaying (false);
+            else if (block == 250)
+                harness.playHead.setPlaying (true);
+
+            midi.clear();
+            writeInputClocks (buffer, midi, static_cast<juce::int64> (block) * buffer.getNumSamples());
+            harness.render (buffer, midi, block >= 300 && block < 350);
+        }
+    }
+}
+
+//==============================================================================
+class ProcessorTests : public juce::UnitTest
+{
+public:
+    ProcessorTests() : juce::UnitTest ("Processor", "Clockmaker") {}
+
+    void runTest() override
+    {
+        beginTest ("Runs without a playhead");
+        {
+            ProcessorHarness harness (48000.0, 512);
+            harness.processor.setPlayHead (nullptr);
+
+            auto buffer = harness.makeBuffer<float>();
+            juce::MidiBuffer midi;
+            buffer.clear();
+            buffer.setSample (0, 0, 1.f);
+            harness.processor.processBlock (buffer, midi);
+
+            expectEquals (buffer.getMagnitude (0, 0, buffer.getNumSamples()), 0.f, "A stopped clock is silent");
+        }
+
+        beginTest ("Pulses follow the scripted playhead");
+        {
+            // 24 PPQN at 120 BPM and 48 kHz is a pulse every 1000 samples
+            ProcessorHarness harness (48000.0, 512);
+            harness.playHead.setTempo (120.0);
+            harness.playHead.setPlaying (true);
+
+            auto buffer = harness.makeBuffer<float>();
+            juce::MidiBuffer midi;
+            juce::Array<juce::int64> edges;
+            float lastSample = 0.f;
+
+            for (int block = 0; block < 200; ++block)
+            {
+                harness.render (buffer, midi);
+                findRisingEdges (harness.getOutput (buffer, 0), buffer.getNumSamples(),
+                                 static_cast<juce::int64> (block) * buffer.getNumSamples(), lastSample, edges);
+            }
+
+            expectEquals (edges.size(), 103);
+
+            for (int i = 0; i < edges.size(); ++i)
+                expectEquals (edges[i], static_cast<juce::int64> (i) * 1000);
+        }
+
+        beginTest ("The scope shows each pulse at its exact time");
+        {
+            // 24 PPQN at 120 BPM and 44.1 kHz is a pulse every 918.75 samples
+            ProcessorHarness harness (44100.0, 512);
+            harness.playHead.setTempo (120.0);
+            harness.playHead.setPlaying (true);
+
+            auto& scope = harness.processor.getPulseScope();
+            scope.SetEnabled (true);
+
+            auto buffer = harness.makeBuffer<float>();
+            juce::MidiBuffer midi;
+
+            for (int block = 0; block < 20; ++block)
+                harness.render (buffer, midi);
+
+            std::array<dingus_dsp::PulseScope::Edge, 64> edges;
+            int numEdges = scope.ReadEdges (edges.data(), static_cast<int> (edges.size()));
+            int pulse = 0;
+
+            for (size_t i = 0; i < static_cast<size_t> (numEdges); ++i)
+            {
+                if (edges[i].trace != 0)
+                    continue;
+
+                expectWithinAbsoluteError (edges[i].time, pulse * 918.75, 1.0e-6);
+                ++pulse;
+            }
+
+            // 20 blocks of 512 samples hold 12 pulses
+            expectEquals (pulse, 12);
+            scope.SetEnabled (false);
+        }
+
+        beginTest ("Divided clocks stay on the bar over long playback");
+        {
+            // A 7/8 bar is 3.5 quarter notes, which does not hold a whole number of
+            // pulses of a 4 PPQN clock divided by 3, so the grid restarts every bar.
+            // Playback starts part way through a bar and runs for an hour.
+            const double startPpq = 12.0;
+            const double barLength = 3.5;
+            const double pulseLength = 0.75;
+            const double samplesPerQuarter = 24000.0;
+
+            ProcessorHarness harness (48000.0, 512);
+            harness.setParameter ("ppqn", 4.f);
+            harness.setParameter ("mulDiv", -3.f);
+            harness.playHead.setTempo (120.0);
+            harness.playHead.setTimeSignature (7, 8);
+            harness.playHead.setPosition (startPpq);
+            harness.playHead.setPlaying (true);
+
+            auto buffer = harness.makeBuffer<float>();
+            juce::MidiBuffer midi;
+            juce::Array<juce::int64> edges;
+            float lastSample = 0.f;
+            juce::int64 totalSamples = static_cast<juce::int64> (3600.0 * harness.sampleRate);
+
+            for (juce::int64 blockStart = 0; blockStart < totalSamples; blockStart += buffer.getNumSamples())
+            {
+                harness.render (buffer, midi);
+                findRisingEdges (harness.getOutput (buffer, 0), buffer.getNumSamples(), blockStart, lastSample, edges);
+            }
+
+            // Every bar starts with a pulse, then one every 0.75 quarter notes until the next bar
+            juce::Array<juce::int64> expected;
+
+            for (double bar = std::floor (startPpq / barLength) * barLength; (bar - startPpq) * samplesPerQuarter < totalSamples; bar += barLength)
+            {
+                for (int pulse = 0; pulse * pulseLength < barLength; ++pulse)
+                {
+                    double position = bar + pulse * pulseLength;
+                    auto sample = static_cast<juce::int64> (std::llround ((position - startPpq) * samplesPerQuarter));
+
+                    if (position >= startPpq && sample < totalSamples)
+                        expected.add (sample);
+                }
+            }
+
+            logMessage (juce::String (edges.size()) + " pulses over an hour of 7/8");
+            expectEquals (countDifferences (edges, expected), 0, "Pulses off the bar grid");
+        }
+
+        beginTest ("MIDI start waits for a 16th note");
+        {
+            // At 120 BPM and 48 kHz a tick is 1000 samples and a 16th note 6000.
+            // From 1.1 quarter notes the first tick is at 1.125, and the first
+            // on a 16th is at 1.25, 3600 samples in.
+            ProcessorHarness harness (48000.0, 512);
+            auto sent = startMidiClock (harness, 1.1, 20);
+
+            expect (sent.size() >= 3, "Messages sent");
+            expect (sent[0].message.isSongPositionPointer(), "Song position first");
+            expectEquals (sent[0].message.getSongPositionPointerMidiBeat(), 5);
+            expect (sent[1].message.isMidiContinue(), "Then continue");
+            expect (sent[2].message.isMidiClock(), "Then the first tick");
+
+            for (int i = 0; i < 3; ++i)
+                expectEquals (sent[i].sample, static_cast<juce::int64> (3600));
+        }
+
+        beginTest ("MIDI song position follows the offset");
+        {
+            // Ten milliseconds early moves the MIDI clock back from 1.26 to 1.24 quarter
+            // notes, so the first 16th is 1.25, 240 samples in, rather than 1.5.  The
+            // offset is a float parameter, so the tick may round to the next sample.
+            ProcessorHarness harness (48000.0, 512);
+            harness.setParameter ("offset", -10.f);
+            auto sent = startMidiClock (harness, 1.26, 4);
+
+            expect (sent.size() >= 3 && sent[0].message.isSongPositionPointer(), "Song position first");
+            expectEquals (sent[0].message.getSongPositionPointerMidiBeat(), 5);
+            expect (sent[0].sample >= 240 && sent[0].sample <= 241, "Sent on the 16th note");
+        }
+
+        beginTest ("MIDI song position is clamped to 14 bits");
+        {
+            ProcessorHarness harness (48000.0, 512);
+            auto sent = startMidiClock (harness, 5000.0, 4);
+
+            expect (sent.size() >= 3 && sent[0].message.isSongPositionPointer(), "Song position first");
+            expectEquals (sent[0].message.getSongPositionPointerMidiBeat(), 0x3FFF);
+            expect (sent[1].message.isMidiContinue(), "Then continue");
+        }
+
+        beginTest ("Reset, run and MIDI follow start, loop wrap and stop");
+        {
+            // A one quarter note loop is 24000 samples, so the loop wraps 448
+            // samples into block 46 and every 46.875 blocks after
+            ProcessorHarness harness (48000.0, 512, 1, true);
+            harness.playHead.setTempo (120.0);
+            harness.playHead.setLoop (0.0, 1.0);
+            harness.playHead.setPlaying (true);
+
+            auto buffer = harness.makeBuffer<float>();
+            juce::MidiBuffer midi;
+            juce::Array<juce::int64> resets, runs, stops;
+            juce::Array<SentMessage> starts;
+            float lastReset = 0.f, lastRun = 0.f;
+            float runBeforeStop = 0.f, runAfterStop = 1.f;
+
+            for (int block = 0; block < 120; ++block)
+            {
+                auto blockStart = static_cast<juce::int64> (block) * buffer.getNumSamples();
+
+                if (block == 100)
+                {
+                    harness.playHead.setPlaying (false);
+                    harness.playHead.setLoop (0.0, 0.0);
+                }
+
+                midi.clear();
+                harness.render (buffer, midi);
+                findRisingEdges (harness.getOutput (buffer, resetBus), buffer.getNumSamples(), blockStart, lastReset, resets);
+                findRisingEdges (harness.getOutput (buffer, runBus), buffer.getNumSamples(), blockStart, lastRun, runs);
+
+                if (block == 99)
+                    runBeforeStop = harness.getOutput (buffer, runBus)[buffer.getNumSamples() - 1];
+                else if (block == 100)
+                    runAfterStop = harness.getOutput (buffer, runBus)[0];
+
+                for (const auto metadata : midi)
+                {
+                    auto message = metadata.getMessage();
+                    auto sample = blockStart + metadata.samplePosition;
+
+                    if (message.isMidiStop())
+                        stops.add (sample);
+                    else if (message.isSongPositionPointer() || message.isMidiStart() || message.isMidiContinue())
+                        starts.add ({ sample, message });
+                }
+            }
+
+            // Resets at the start and every loop wrap, before the stop at block 100
+            expectEquals (resets.size(), 3, "Resets");
+
+            for (int i = 0; i < resets.size(); ++i)
+                expectEquals (resets[i], static_cast<juce::int64> (i) * 24000);
+
+            expectEquals (runs.size(), 1, "Run starts");
+            expect (runs.size() > 0 && runs[0] == 0, "Run high from the start");
+            expectEquals (runBeforeStop, 1.f, "Run high while playing");
+            expectEquals (runAfterStop, 0.f, "Run low once stopped");
+
+            // MIDI stops at each wrap and starts again from the loop start, then stops with the transport
+            expectEquals (stops.size(), 3, "MIDI stops");
+            expect (stops.size() == 3 && stops[0] == 24000 && stops[1] == 48000 && stops[2] == 51200, "MIDI stops at each wrap and the stop");
+            expectEquals (starts.size(), 6, "MIDI song positions and starts");
+
+            for (int i = 0; i < starts.size(); ++i)
+            {
+                expectEquals (starts[i].sample, static_cast<juce::int64> (i / 2) * 24000);
+                expect (i % 2 == 0 ? starts[i].message.isSongPositionPointer() : starts[i].message.isMidiStart());
+            }
+        }
+
+        beginTest ("Transport changes while bypassed are sent when the bypass ends");
+        {
+            // A locate, a stop and a start each happen while bypassed.  The
+            // first rendered block after each one sends what was missed.
+            ProcessorHarness harness (48000.0, 512, 1, true);
+            harness.playHead.setTempo (120.0);
+            harness.playHead.setPlaying (true);
+
+            auto buffer = harness.makeBuffer<float>();
+            juce::MidiBuffer midi;
+            juce::Array<juce::int64> resets, stops;
+            float lastReset = 0.f;
+            float runAfterStop = 1.f, runAfterStart = 0.f;
+
+            for (int block = 0; block < 75; ++block)
+            {
+                auto blockStart = static_cast<juce::int64> (block) * buffer.getNumSamples();
+
+                if (block == 25)
+                    harness.playHead.setPosition (16.0);
+                else if (block == 55)
+                    harness.playHead.setPlaying (false);
+                else if (block == 67)
+                    harness.playHead.setPlaying (true);
+
+                bool bypassed = (block >= 20 && block < 30) || (block >= 50 && block < 60) || (block >= 65 && block < 70);
+
+                midi.clear();
+                harness.render (buffer, midi, bypassed);
+
+                if (bypassed)
+                    continue;
+
+                findRisingEdges (harness.getOutput (buffer, resetBus), buffer.getNumSamples(), blockStart, lastReset, resets);
+
+                if (block == 60)
+                    runAfterStop = harness.getOutput (buffer, runBus)[0];
+                else if (block == 70)
+                    runAfterStart = harness.getOutput (buffer, runBus)[0];
+
+                for (const auto metadata : midi)
+                    if (metadata.getMessage().isMidiStop())
+                        stops.add (blockStart + metadata.samplePosition);
+            }
+
+            // Resets at the start, and where the locate and the start are picked up
+            expectEquals (resets.size(), 3, "Resets");
+            expect (resets.size() == 3 && resets[0] == 0 && resets[1] == 30 * 512 && resets[2] == 70 * 512, "Resets when the bypass ends");
+
+            // MIDI stops before moving to the located position, then for the stop
+            expectEquals (stops.size(), 2, "MIDI stops");
+            expect (stops.size() == 2 && stops[0] == 30 * 512 && stops[1] == 60 * 512, "MIDI stops when the bypass ends");
+
+            expectEquals (runAfterStop, 0.f, "Run low after a stop while bypassed");
+            expectEquals (runAfterStart, 1.f, "Run high after a start while bypassed");
+        }
+
+        beginTest ("A negative offset delays every output together");
+        {
+            // 50 ms late at 120 BPM and 48 kHz puts the clocks 2400 samples behind
+            // the playhead.  Nothing is output for the positions before the start,
+            // then the first pulse, the reset and the run output start together.
+            ProcessorHarness harness (48000.0, 512, 1, true);
+            harness.setParameter ("offset", -50.f);
+            harness.playHead.setTempo (120.0);
+            harness.playHead.setPlaying (true);
+
+            auto buffer = harness.makeBuffer<float>();
+            juce::MidiBuffer midi;
+            juce::Array<juce::int64> pulses, resets, runs;
+            float lastPulse = 0.f, lastReset = 0.f, lastRun = 0.f;
+
+            for (int block = 0; block < 20; ++block)
+            {
+                auto blockStart = static_cast<juce::int64> (block) * buffer.getNumSamples();
+                harness.render (buffer, midi);
+                findRisingEdges (harness.getOutput (buffer, 0), buffer.getNumSamples(), blockStart, lastPulse, pulses);
+                findRisingEdges (harness.getOutput (buffer, resetBus), buffer.getNumSamples(), blockStart, lastReset, resets);
+                findRisingEdges (harness.getOutput (buffer, runBus), buffer.getNumSamples(), blockStart, lastRun, runs);
+            }
+
+            expect (pulses.size() > 0 && pulses[0] == 2400, "First pulse at the start position");
+            expectEquals (resets.size(), 1, "Resets");
+            expect (resets.size() > 0 && resets[0] == 2400, "Reset with the first pulse");
+            expectEquals (runs.size(), 1, "Run starts");
+            expect (runs.size() > 0 && runs[0] == 2400, "Run with the first pulse");
+        }
+
+        beginTest ("MIDI start waits for the next tick");
+        {
+            // Ticks every 1000 samples lock the follower, then Start arrives in a
+            // block with no tick.  The song starts on the next tick, in the
+            // following block.
+            const juce::int64 startSample = 20580;
+            const juce::int64 firstTick = 21000;
+
+            ProcessorHarness harness (48000.0, 512, 1, true);
+            harness.setParameter ("sync", 2.f);
+
+            auto buffer = harness.makeBuffer<float>();
+            juce::MidiBuffer midi;
+            juce::Array<juce::int64> pulses, resets;
+            float lastPulse = 0.f, lastReset = 0.f;
+
+            for (int block = 0; block < 100; ++block)
+            {
+                auto blockStart = static_cast<juce::int64> (block) * buffer.getNumSamples();
+                midi.clear();
+
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                {
+                    if ((blockStart + i) % 1000 == 0)
+                        midi.addEvent (juce::MidiMessage::midiClock(), i);
+
+                    if (blockStart + i == startSample)
+                        midi.addEvent (juce::MidiMessage::midiStart(), i);
+                }
+
+                buffer.clear();
+                harness.render (buffer, midi);
+                findRisingEdges (harness.getOutput (buffer, 0), buffer.getNumSamples(), blockStart, lastPulse, pulses);
+                findRisingEdges (harness.getOutput (buffer, resetBus), buffer.getNumSamples(), blockStart, lastReset, resets);
+            }
+
+            expectEquals (resets.size(), 1, "Resets");
+            expect (pulses.size() > 0 && std::abs (pulses[0] - firstTick) <= 1, "First pulse on the first tick after start");
+        }
+
+        beginTest ("Saved states load, newer formats are ignored");
+        {
+            ProcessorHarness source (48000.0, 512);
+            source.setParameter ("ppqn", 48.f);
+            source.setParameter ("swing", 60.f);
+
+            juce::MemoryBlock state;
+            source.processor.getStateInformation (state);
+
+            ProcessorHarness target (48000.0, 512);
+            target.processor.setStateInformation (state.getData(), static_cast<int> (state.getSize()));
+            expectEquals (target.getParameter ("ppqn"), 48.f);
+            expectEquals (target.getParameter ("swing"), 60.f);
+
+            // The same state marked as a later format version
+            juce::MemoryBlock newerState (state);
+            auto newerVersion = juce::ByteOrder::swapIfBigEndian (static_cast<juce::uint32> (2));
+            newerState.copyFrom (&newerVersion, 4, sizeof (newerVersion));
+
+            ProcessorHarness older (48000.0, 512);
+            older.setParameter ("ppqn", 12.f);
+            older.processor.setStateInformation (newerState.getData(), static_cast<int> (newerState.getSize()));
+            expectEquals (older.getParameter ("ppqn"), 12.f, "A newer state is not read");
+        }
+
+        beginTest ("The real-time check catches allocations and blocking calls");
+        {
+            if (CLOCKMAKER_REALTIME_CHECKS)
+            {
+                std::mutex mutex;
+                auto before = dingus_dsp::RealtimeCheck::GetViolationCount();
+                int allocations, locks;
+
+                {
+                    dingus_dsp::RealtimeCheck::ScopedRealtime realtime;
+                    auto allocated = std::make_unique<int> (1);
+                    allocations = dingus_dsp::RealtimeCheck::GetViolationCount() - before;
+
+                    const std::lock_guard<std::mutex> lock (mutex);
+                    locks = dingus_dsp::RealtimeCheck::GetViolationCount() - before - allocations;
+                }
+
+                expectGreaterThan (allocations, 0, "Allocations counted");
+
+               #if JUCE_LINUX
+                expectGreaterThan (locks, 0, "Locks counted");
+               #else
+                juce::ignoreUnused (locks);
+               #endif
+            }
+        }
+
+        beginTest ("Every mode stays real-time safe");
+        {
+            if (! CLOCKMAKER_REALTIME_CHECKS)
+                logMessage ("Real-time checks are off, build in Debug or with CLOCKMAKER_REALTIME_CHECKS to check for violations");
+
+            const ProcessorMode modes[] = {
+                { "Default", {} },
+                { "No MIDI clock", { { "midiClock", 0.f } } },
+                { "Band limited", { { "bandLimited", 1.f } } },
+                { "Song aligned", { { "align", 1.f }, { "mulDiv", -3.f } } },
+                { "Positive offset", { { "offset", 10.f } } },
+                { "Negative offset", { { "offset", -10.f } } },
+                { "Trigger and swing", { { "trigger", 5.f }, { "swing", 66.f }, { "ppqn", 4.f } } },
+                { "Euclidean", { { "steps", 13.f }, { "hits", 5.f }, { "rotate", 2.f } } },
+                { "Input sync", { { "sync", 1.f } } },
+                { "MIDI sync", { { "sync", 2.f } } }
+            };
+
+            for (auto& mode : modes)
+            {
+                for (bool doublePrecision : { false, true })
+                {
+                    ProcessorHarness harness (48000.0, 256, 2, true);
+
+                    for (auto& value : mode.values)
+                        harness.setParameter (value.parameterId, value.value);
+
+                    auto violations = dingus_dsp::RealtimeCheck::GetViolationCount();
+
+                    if (doublePrecision)
+                    {
+                        harness.setDoublePrecision();
+                        runTransportScript<double> (harness);
+                    }
+                    else
+                    {
+                        runTransportScript<float> (harness);
+                    }
+
+                    expectEquals (dingus_dsp::RealtimeCheck::GetViolationCount() - violations, 0,
+                                  juce::String (mode.name) + (doublePrecision ? ", double" : ", float") + " violations");
+                }
+            }
+        }
+    }
+};
+
+static ProcessorTests processorTests;
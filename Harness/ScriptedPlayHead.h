@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    File: scriptedplayhead.h
+    Author: Daniel Schwartz
+    Description: A host transport driven by the offline harness.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace clockmaker_harness
+{
+    // A host transport driven by the offline harness.
+    // The position is worked out from a sample counter like a host's, and moves
+    // on by the length of each block.  The tempo, time signature, loop and
+    // transport can be changed between blocks.
+    class ScriptedPlayHead : public juce::AudioPlayHead
+    {
+    public:
+        ScriptedPlayHead()
+        {
+            info.resetToDefault();
+        }
+
+        bool getCurrentPosition (CurrentPositionInfo& result) override
+        {
+            result = info;
+            return true;
+        }
+
+        void setSampleRate (double newSampleRate)
+        {
+            sampleRate = newSampleRate;
+            update();
+        }
+
+        // Start or stop the transport, leaving the position where it is
+        void setPlaying (bool shouldPlay)
+        {
+            info.isPlaying = shouldPlay;
+        }
+
+        // Change the tempo from the current position on
+        void setTempo (double bpm)
+        {
+            restartSegment();
+            info.bpm = bpm;
+            update();
+        }
+
+        void setTimeSignature (int numerator, int denominator)
+        {
+            info.timeSigNumerator = numerator;
+            info.timeSigDenominator = denominator;
+            update();
+        }
+
+        // Locate to a position in quarter notes
+        void setPosition (double ppqPosition)
+        {
+            segmentPpq = ppqPosition;
+            segmentSamples = 0;
+            update();
+        }
+
+        // Loop between two positions in quarter notes, or stop looping if they are equal
+        void setLoop (double loopStart, double loopEnd)
+        {
+            info.isLooping = loopEnd > loopStart;
+            info.ppqLoopStart = loopStart;
+            info.ppqLoopEnd = loopEnd;
+        }
+
+        // Move on by one block, wrapping around the loop like a host
+        void advance (int numSamples)
+        {
+            info.timeInSamples += numSamples;
+
+            if (! info.isPlaying)
+                return;
+
+            segmentSamples += numSamples;
+            update();
+
+            if (info.isLooping && info.ppqPosition >= info.ppqLoopEnd)
+                setPosition (info.ppqLoopStart + (info.ppqPosition - info.ppqLoopEnd));
+        }
+
+        const CurrentPositionInfo& getInfo() const { return info; }
+
+    private:
+        CurrentPositionInfo info;
+        double sampleRate = 44100.0;
+
+        // The position at the last tempo change or locate, and the samples played since
+        double segmentPpq = 0.0;
+        juce::int64 segmentSamples = 0;
+
+        void restartSegment()
+        {
+            segmentPpq = info.ppqPosition;
+            segmentSamples = 0;
+        }
+
+        void update()
+        {
+            info.ppqPosition = segmentPpq + segmentSamples * info.bpm / (60.0 * sampleRate);
+            info.timeInSeconds = info.timeInSamples / sampleRate;
+
+            double barLength = 4.0 * info.timeSigNumerator / info.timeSigDenominator;
+            info.ppqPositionOfLastBarStart = std::floor (info.ppqPosition / barLength) * barLength;
+        }
+    };
+}
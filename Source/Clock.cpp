@@ -8,11 +8,13 @@
   ==============================================================================
 */
 
-#include "clock.h"
+#include "Clock.h"
+
+#include <numeric>
 
 using namespace dingus_dsp;
 
-void Clock::Init(float sample_rate)
+void Clock::Init(double sample_rate)
 {
     sample_rate_ = sample_rate;
     Reset();
@@ -21,38 +23,459 @@ void Clock::Init(float sample_rate)
 
 float Clock::Process()
 {
-    float sample = (phase_ < juce::MathConstants<float>::pi) ? 1 : -1;
+    float sample;
+    ProcessBlock(&sample, 1);
+    return sample;
+}
 
-    phase_ += delta_;
+template <typename SampleType>
+void Clock::ProcessBlock(SampleType* out, int num_samples)
+{
+    const SampleType lowLevel = -1;
+    const SampleType highLevel = 1;
 
-    if (phase_ > juce::MathConstants<float>::twoPi)
+    // A stopped clock just holds its current level
+    if (!IsRunning())
     {
-        phase_ -= juce::MathConstants<float>::twoPi;
+        juce::FloatVectorOperations::fill(out, FirstEdge().rising ? lowLevel : highLevel, num_samples);
+        return;
     }
 
-    return sample;
+    // A pattern with no hits stays low while the phase moves on
+    if (silent_)
+    {
+        juce::FloatVectorOperations::fill(out, lowLevel, num_samples);
+        Advance(num_samples);
+        return;
+    }
+
+    // Edges are located relative to the phase at the start of the block rather
+    // than by accumulating the delta, so rounding errors do not build up.
+    const double start = phase_;
+    EdgeCursor cursor = FirstEdge();
+    bool high = !cursor.rising;
+    int i = 0;
+
+    while (i < num_samples)
+    {
+        // The first sample at or after the edge
+        double edgeTime = SamplesUntil(cursor.edge - start);
+        double edgeSample = EdgeSample(edgeTime);
+        int end = edgeSample < num_samples ? juce::jmax(0, static_cast<int>(edgeSample)) : num_samples;
+
+        if (telemetry_ != nullptr && end < num_samples)
+            telemetry_->AddEdgeError(end - edgeTime);
+
+        if (end > i)
+        {
+            juce::FloatVectorOperations::fill(out + i, high ? highLevel : lowLevel, end - i);
+            i = end;
+        }
+
+        high = cursor.rising;
+        NextEdge(cursor);
+    }
+
+    if (band_limited_)
+        ApplyBandLimiting(out, num_samples);
+
+    Advance(num_samples);
+}
+
+template <typename SampleType>
+void Clock::ApplyBandLimiting(SampleType* out, int num_samples) const
+{
+    // Each edge only changes the sample on either side of it, so the cost is
+    // proportional to the number of edges.  The sample before an edge at the
+    // start of the block and the sample after an edge at the end of the block
+    // are corrected by the neighbouring blocks.
+    const double start = phase_;
+    EdgeCursor cursor = FirstEdge();
+
+    while (true)
+    {
+        // The exact, fractional time of the edge in samples
+        double edgeTime = SamplesUntil(cursor.edge - start);
+
+        if (!(edgeTime < num_samples))
+            break;
+
+        int after = static_cast<int>(EdgeSample(edgeTime));
+        double t = juce::jmax(0.0, after - edgeTime);
+        SampleType direction = cursor.rising ? SampleType(1) : SampleType(-1);
+
+        if (after >= 0 && after < num_samples)
+            out[after] -= direction * static_cast<SampleType>((1.0 - t) * (1.0 - t));
+
+        if (after >= 1)
+            out[after - 1] += direction * static_cast<SampleType>(t * t);
+
+        NextEdge(cursor);
+    }
 }
 
-void Clock::SetTimeAdvance(int time_samples)
+int Clock::GetEdges(Edge* edges, int max_edges, int num_samples) const
 {
-    phase_ = delta_ * time_samples;
-    phase_ = std::fmodf(phase_, juce::MathConstants<float>::twoPi);
+    if (!IsRunning())
+        return 0;
+
+    const double start = phase_;
+    EdgeCursor cursor = FirstEdge();
+    int count = 0;
+
+    while (count < max_edges)
+    {
+        double edgeTime = SamplesUntil(cursor.edge - start);
+        double edgeSample = EdgeSample(edgeTime);
+
+        if (!(edgeSample < num_samples))
+            break;
+
+        int offset = juce::jmax(0, static_cast<int>(edgeSample));
+        edges[count++] = { offset, cursor.rising, offset - edgeTime };
+        NextEdge(cursor);
+    }
+
+    return count;
 }
 
-void Clock::SetMulDiv(int mulDiv)
+int Clock::ProcessEdges(Edge* edges, int max_edges, int num_samples)
+{
+    int count = GetEdges(edges, max_edges, num_samples);
+
+    if (telemetry_ != nullptr)
+    {
+        for (int i = 0; i < count; ++i)
+            telemetry_->AddEdgeError(edges[i].error);
+    }
+
+    Advance(num_samples);
+    return count;
+}
+
+Clock::EdgeCursor Clock::FirstEdge() const
+{
+    EdgeCursor cursor;
+    cursor.restart = phase_ + (restart_cycles_ - unit_phase_);
+
+    if (silent_)
+    {
+        cursor.edge = std::numeric_limits<double>::infinity();
+        cursor.rising = true;
+        cursor.cycle = 0.0;
+        cursor.step = 0;
+        cursor.hit = 0;
+        return cursor;
+    }
+
+    // The current cycle starts at zero relative to the phase, and its index is
+    // the number of whole cycles since the grid restarted.  A delayed step can
+    // still be high after the next cycle starts, so begin from the cycle before.
+    juce::int64 first = static_cast<juce::int64>(unit_phase_) - 1;
+    cursor.cycle = -1.0;
+
+    if (first < 0 && std::isfinite(restart_cycles_))
+    {
+        // The cycle before a restart is cut short by it
+        double lastCycle = std::ceil(restart_cycles_) - 1.0;
+        first = static_cast<juce::int64>(lastCycle);
+        cursor.cycle = lastCycle - restart_cycles_;
+        cursor.restart = 0.0;
+    }
+
+    // Start from the end of the cycle before that, so moving on finds the first
+    // cycle with a hit
+    first += period_steps_ - 1;
+    cursor.step = static_cast<int>(first % groove_steps_);
+    cursor.hit = static_cast<int>(first % pattern_steps_);
+    cursor.cycle -= 1.0;
+    cursor.rising = false;
+    NextEdge(cursor);
+
+    // An edge crossed between the previous sample and the start of the block
+    // belongs to this block, so search from the previous sample's position.  An
+    // edge within the tolerance after the previous sample was placed on it by
+    // the last block, so it is left out.
+    double previous = phase_ - delta_ * (1.0 - edge_tolerance_);
+
+    while (cursor.edge <= previous)
+        NextEdge(cursor);
+
+    return cursor;
+}
+
+void Clock::NextEdge(EdgeCursor& cursor) const
+{
+    if (cursor.rising)
+    {
+        cursor.edge = cursor.cycle + fall_[static_cast<size_t>(cursor.step)];
+        cursor.rising = false;
+        ApplyRestart(cursor);
+        return;
+    }
+
+    // Cycles without a hit in the pattern have no edges, so skip straight over
+    // them.  Every pattern has a hit before the grid restarts, or it is silent,
+    // but the search is bounded so the audio thread can never spin here.  A hit
+    // is always found within one period, or one period after a restart.
+    cursor.rising = true;
+    int remaining = 2 * period_steps_ + 1;
+
+    do
+    {
+        if (--remaining < 0)
+        {
+            cursor.edge = std::numeric_limits<double>::infinity();
+            return;
+        }
+
+        cursor.cycle += 1.0;
+        cursor.step = (cursor.step + 1 == groove_steps_) ? 0 : cursor.step + 1;
+        cursor.hit = (cursor.hit + 1 == pattern_steps_) ? 0 : cursor.hit + 1;
+        cursor.edge = cursor.cycle + rise_[static_cast<size_t>(cursor.step)];
+        ApplyRestart(cursor);
+    }
+    while (!IsHit(cursor.hit));
+}
+
+void Clock::ApplyRestart(EdgeCursor& cursor) const
+{
+    // A restart begins a new cycle on the first step, so a rising edge due after
+    // it moves back to the restart.  A pulse that is already high stays high for
+    // the first step's pulse if that is a hit, or ends at the restart if not.
+    // The first pulse is kept shorter than the restart length so this always
+    // moves forward.
+    while (cursor.edge >= cursor.restart)
+    {
+        cursor.cycle = cursor.restart;
+        cursor.step = 0;
+        cursor.hit = 0;
+
+        if (cursor.rising)
+            cursor.edge = cursor.restart + rise_[0];
+        else
+            cursor.edge = cursor.restart + (IsHit(0) ? fall_[0] : 0.0);
+
+        cursor.restart += restart_cycles_;
+    }
+}
+
+void Clock::Advance(int num_samples)
+{
+    unit_phase_ += delta_ * num_samples + 0.5 * delta_slope_ * num_samples * num_samples;
+
+    if (std::isfinite(restart_cycles_))
+        unit_phase_ = std::fmod(unit_phase_, restart_cycles_);
+    else
+        unit_phase_ = std::fmod(unit_phase_, static_cast<double>(period_steps_));
+
+    phase_ = unit_phase_ - std::floor(unit_phase_);
+
+    // Land on the tempo reached at the end of any ramp
+    if (tempo_slope_ != 0.0)
+    {
+        tempo_ += tempo_slope_ * num_samples;
+        tempo_slope_ = 0.0;
+        UpdateDelta();
+    }
+}
+
+void Clock::SetTempoRamp(double end_tempo, int num_samples)
+{
+    tempo_slope_ = num_samples > 0 ? (end_tempo - tempo_) / num_samples : 0.0;
+    UpdateDelta();
+}
+
+void Clock::SetPpqPosition(double ppq_position, double ppq_origin)
 {
-    if (mulDiv < -1.f)
-        mulDiv_ = 1.f / (-1.f * mulDiv);
-    else if (mulDiv > 1.f)
-        mulDiv_ = mulDiv;
+    double position = ppq_position - ppq_origin;
+
+    if (restart_quarters_ > 0.0)
+    {
+        // Only the position since the last restart matters, which is short
+        // enough to convert to cycles directly
+        position -= std::floor(position / restart_quarters_) * restart_quarters_;
+        unit_phase_ = position * CyclesPerQuarter();
+
+        if (!std::isfinite(restart_cycles_))
+            unit_phase_ = std::fmod(unit_phase_, static_cast<double>(period_steps_));
+    }
     else
-        mulDiv_ = 1.f;
+    {
+        // Whole quarter notes are reduced with integer arithmetic, so the phase
+        // and step stay exact however far the position is from the origin
+        const juce::int64 period = static_cast<juce::int64>(div_) * period_steps_;
+        double quarters = std::floor(position);
+        juce::int64 wholeCycles = (static_cast<juce::int64>(quarters) * ppqn_ * mul_) % period;
+
+        if (wholeCycles < 0)
+            wholeCycles += period;
+
+        unit_phase_ = (wholeCycles + (position - quarters) * ppqn_ * mul_) / div_;
+        unit_phase_ = std::fmod(unit_phase_, static_cast<double>(period_steps_));
+    }
+
+    phase_ = unit_phase_ - std::floor(unit_phase_);
+}
+
+void Clock::SetMulDiv(int mulDiv)
+{
+    mul_ = 1;
+    div_ = 1;
+
+    if (mulDiv < -1)
+        div_ = -mulDiv;
+    else if (mulDiv > 1)
+        mul_ = mulDiv;
+
+    UpdateDelta();
+}
+
+void Clock::SetSwing(double swing)
+{
+    // The second step of each pair starts at swing of the way through the pair
+    double offset = juce::jlimit(0.0, 0.5, 2.0 * swing - 1.0);
+    const double offsets[] = { 0.0, offset };
+
+    SetGroove(offsets, offset > 0.0 ? 2 : 0);
+}
+
+void Clock::SetGroove(const double* offsets, int num_steps)
+{
+    num_steps = juce::jlimit(1, maxGrooveSteps, num_steps);
+
+    // Compiling the groove is cheap but is skipped when nothing changed, so the
+    // groove can be set on every block
+    bool changed = num_steps != groove_steps_;
+
+    for (size_t i = 1; i < static_cast<size_t>(num_steps) && !changed; ++i)
+        changed = groove_[i] != juce::jlimit(0.0, 0.5, offsets[i]);
+
+    if (!changed)
+        return;
+
+    groove_steps_ = num_steps;
+    period_steps_ = std::lcm(groove_steps_, pattern_steps_);
+    groove_[0] = 0.0;
+
+    for (size_t i = 1; i < static_cast<size_t>(num_steps); ++i)
+        groove_[i] = juce::jlimit(0.0, 0.5, offsets[i]);
 
     UpdateDelta();
 }
 
+void Clock::SetEuclidean(int hits, int num_steps, int rotation)
+{
+    // Spread the hits as evenly as possible, with the first one on the first step
+    num_steps = juce::jlimit(1, maxPatternSteps, num_steps);
+    hits = juce::jlimit(0, num_steps, hits);
+    rotation = ((rotation % num_steps) + num_steps) % num_steps;
+
+    std::uint64_t pattern = 0;
+
+    for (int i = 0; i < num_steps; ++i)
+    {
+        if ((((i + rotation) * hits) % num_steps) < hits)
+            pattern |= std::uint64_t(1) << i;
+    }
+
+    SetPattern(pattern, num_steps);
+}
+
+void Clock::SetPattern(std::uint64_t pattern, int num_steps)
+{
+    num_steps = juce::jlimit(1, maxPatternSteps, num_steps);
+
+    if (num_steps < maxPatternSteps)
+        pattern &= (std::uint64_t(1) << num_steps) - 1;
+
+    if (pattern == pattern_ && num_steps == pattern_steps_)
+        return;
+
+    pattern_ = pattern;
+    pattern_steps_ = num_steps;
+    period_steps_ = std::lcm(groove_steps_, pattern_steps_);
+    UpdateDelta();
+}
+
 void Clock::UpdateDelta()
 {
-    float freq = tempo_ * ppqn_ * mulDiv_ / 60.f;
-    delta_ = juce::MathConstants<float>::twoPi * freq / sample_rate_;
-}
\ No newline at end of file
+    // A restart that always falls at the end of a whole groove and pattern does
+    // not change the grid
+    double restartCycles = restart_quarters_ * CyclesPerQuarter();
+    double restartPeriods = restartCycles / period_steps_;
+
+    if (restart_quarters_ > 0.0 && std::abs(restartPeriods - std::round(restartPeriods)) > 1e-9)
+        restart_cycles_ = restartCycles;
+    else
+        restart_cycles_ = std::numeric_limits<double>::infinity();
+
+    if (sample_rate_ > 0.0)
+    {
+        double cyclesPerBeatSample = CyclesPerQuarter() / (60.0 * sample_rate_);
+        delta_ = tempo_ * cyclesPerBeatSample;
+        delta_slope_ = tempo_slope_ * cyclesPerBeatSample;
+    }
+    else
+    {
+        delta_ = 0.0;
+        delta_slope_ = 0.0;
+    }
+
+    // A fixed length trigger covers the same number of samples at any rate,
+    // so the edge schedule is unchanged and only the falling edge moves
+    if (trigger_ms_ > 0.0 && sample_rate_ > 0.0)
+        width_ = juce::jlimit(0.0, 0.5, trigger_ms_ * 0.001 * sample_rate_ * delta_);
+    else
+        width_ = pulse_width_;
+
+    CompileGroove();
+
+    // Silent when there are no hits, or the grid always restarts before the
+    // first hit's pulse rises, including any groove delay on that step
+    int firstHit = FirstHit();
+    bool restartsBeforeHit = std::isfinite(restart_cycles_)
+                          && firstHit + rise_[static_cast<size_t>(firstHit % groove_steps_)] >= restart_cycles_;
+    silent_ = pattern_ == 0 || restartsBeforeHit;
+}
+
+void Clock::CompileGroove()
+{
+    // Each step is stretched or squeezed by the offset of the step after it.  A
+    // width keeps its share of the step, a trigger keeps its length but never
+    // covers more than half the step, so steps never overlap.
+    auto steps = static_cast<size_t>(groove_steps_);
+
+    for (size_t i = 0; i < steps; ++i)
+    {
+        double length = 1.0 + groove_[(i + 1) % steps] - groove_[i];
+        double high = (trigger_ms_ > 0.0) ? juce::jmin(width_, 0.5 * length) : width_ * length;
+
+        rise_[i] = groove_[i];
+        fall_[i] = groove_[i] + high;
+    }
+
+    // A pulse must end before the grid restarts
+    if (fall_[0] >= restart_cycles_)
+        fall_[0] = 0.5 * restart_cycles_;
+}
+
+double Clock::SamplesUntil(double distance) const
+{
+    // Solve distance = delta * t + 0.5 * slope * t^2 for t.  This form stays
+    // stable as the slope approaches zero, where it reduces to distance / delta.
+    double discriminant = delta_ * delta_ + 2.0 * delta_slope_ * distance;
+
+    if (discriminant < 0.0)
+        return std::numeric_limits<double>::infinity();
+
+    double denominator = delta_ + std::sqrt(discriminant);
+
+    if (denominator <= 0.0)
+        return std::numeric_limits<double>::infinity();
+
+    return 2.0 * distance / denominator;
+}
+
+template void Clock::ProcessBlock<float>(float* out, int num_samples);
+template void Clock::ProcessBlock<double>(double* out, int num_samples);
\ No newline at end of file
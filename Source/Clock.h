@@ -13,38 +13,91 @@
 #define DINGUS_CLOCK_H
 
 #include <JuceHeader.h>
+#include "Telemetry.h"
 
 namespace dingus_dsp
 {
     // Generates a pulse wave clock signal.
+    // The phase is kept in double precision as a fraction of a pulse cycle so
+    // that edges can be placed on the exact sample of the host timeline.  The
+    // edge schedule does not depend on the sample type, so the same clock can
+    // render float or double blocks.
     class Clock
     {
     public:
+        // A change in the output level at a sample offset within a block, and
+        // how far the offset is after the exact, fractional time of the edge.
+        struct Edge
+        {
+            int offset;
+            bool rising;
+            double error;
+        };
+
         Clock() {}
         ~Clock() {}
 
         // Initialize the clock for playback given the audio rate.
-        void Init(float sample_rate);
+        void Init(double sample_rate);
 
         // Process a single sample.
         float Process();
 
-        // Advance time by some number of samples.
-        void SetTimeAdvance(int time_samples);
+        // Process a block of float or double samples.  The output is rendered
+        // from the edge schedule so each run of +1/-1 is filled in a single pass.
+        template <typename SampleType>
+        void ProcessBlock(SampleType* out, int num_samples);
+
+        // Find the edges within the next num_samples without advancing the clock.
+        // At most max_edges are written in order, returns the number found.
+        int GetEdges(Edge* edges, int max_edges, int num_samples) const;
+
+        // Find the edges within the next num_samples and advance the clock past
+        // them without rendering any samples.
+        int ProcessEdges(Edge* edges, int max_edges, int num_samples);
+
+        // Set the phase from the host position in quarter notes.  The pulse
+        // grid is measured from ppq_origin, e.g. zero or the start of a bar.
+        void SetPpqPosition(double ppq_position, double ppq_origin);
+
+        // Restart the pulse grid every restart_quarters from the origin, so that
+        // divided clocks line up with each bar.  Zero never restarts.
+        void SetRestartLength(double restart_quarters)
+        {
+            restart_quarters = juce::jmax(0.0, restart_quarters);
+
+            // Set on every block, so an unchanged length is skipped
+            if (restart_quarters == restart_quarters_)
+                return;
+
+            restart_quarters_ = restart_quarters;
+            UpdateDelta();
+        }
 
         // Reset the phase.
         void Reset()
         {
             phase_ = 0;
+            unit_phase_ = 0;
         }
 
         // Set the clock tempo (bpm)
-        void SetTempo(float tempo)
+        void SetTempo(double tempo)
         {
+            // Set on every block, so a steady tempo is skipped
+            if (tempo == tempo_ && tempo_slope_ == 0.0)
+                return;
+
             tempo_ = tempo;
+            tempo_slope_ = 0.0;
             UpdateDelta();
         }
 
+        // Ramp the tempo linearly from the current tempo to end_tempo (bpm)
+        // over the next num_samples.  The ramp is consumed by the next call to
+        // ProcessBlock, which should render num_samples samples.
+        void SetTempoRamp(double end_tempo, int num_samples);
+
         /// Set the pulses per quarter note
         void SetPpqn(int ppqn)
         {
@@ -56,27 +109,207 @@ namespace dingus_dsp
         // Positive values will multiply and negative values will divide
         void SetMulDiv(int mulDiv);
 
+        // Set the fraction of each cycle that the pulse is high (0, 1).
+        void SetPulseWidth(double pulse_width)
+        {
+            pulse_width_ = juce::jlimit(0.01, 0.99, pulse_width);
+            UpdateDelta();
+        }
+
+        // Set a fixed pulse length in milliseconds, independent of the clock
+        // rate.  The pulse never exceeds half a cycle.  Zero uses the pulse width.
+        void SetTriggerLength(double trigger_ms)
+        {
+            trigger_ms_ = juce::jmax(0.0, trigger_ms);
+            UpdateDelta();
+        }
+
+        // Delay every second pulse so that it starts swing of the way through
+        // each pair of pulses.  0.5 is straight and 0.75 is the most swing.
+        void SetSwing(double swing);
+
+        // Set a groove of per pulse timing offsets, repeating every num_steps
+        // pulses from the start of the grid.  Offsets are fractions of a cycle
+        // between 0 and 0.5, the first pulse always stays on the grid.
+        void SetGroove(const double* offsets, int num_steps);
+
+        // The most pulses in a groove.
+        static constexpr int maxGrooveSteps = 32;
+
+        // Only output the pulses whose bit is set in pattern, repeating every
+        // num_steps pulses from the start of the grid.  Bit 0 is the first pulse.
+        void SetPattern(std::uint64_t pattern, int num_steps);
+
+        // Spread hits pulses as evenly as possible over num_steps, rotated
+        // earlier by rotation steps.
+        void SetEuclidean(int hits, int num_steps, int rotation);
+
+        // The most pulses in a pattern.
+        static constexpr int maxPatternSteps = 64;
+
+        // Smooth the samples either side of each edge with a PolyBLEP to reduce
+        // aliasing.  Only applies to ProcessBlock.
+        void SetBandLimited(bool band_limited)
+        {
+            band_limited_ = band_limited;
+        }
+
+        // Add the error of every edge rendered by ProcessBlock or ProcessEdges
+        // to telemetry, or nullptr to stop.
+        void SetTelemetry(Telemetry* telemetry)
+        {
+            telemetry_ = telemetry;
+        }
+
+        // An edge this close after a sample is placed on that sample.  The phase
+        // comes from inexact products of the host position, so an edge that is
+        // exactly on a sample is often computed a tiny fraction after it.
+        static constexpr double edge_tolerance_ = 1e-6;
+
+        // The first sample at or after an edge time in samples.
+        static double EdgeSample(double edge_time)
+        {
+            return std::ceil(edge_time - edge_tolerance_);
+        }
+
     private:
         // The tempo in bpm
-        float tempo_{};
+        double tempo_{};
+
+        // The change in tempo per sample while ramping
+        double tempo_slope_{};
 
         // Pulses per quarter note
         int ppqn_{};
 
-        // A multiplier/divider
-        float mulDiv_{ 1.f };
+        // A multiplier and divider, kept as integers so positions far from the
+        // origin can be reduced exactly.
+        int mul_{ 1 };
+        int div_{ 1 };
+
+        // The current phase in cycles [0, 1).
+        double phase_{};
+
+        // The number of cycles since the grid last restarted, or since the
+        // groove last repeated when there are no restarts.
+        double unit_phase_{};
+
+        // The length between grid restarts in quarter notes, zero for none.
+        double restart_quarters_{};
+
+        // The length between grid restarts in cycles.  Infinite when there are no
+        // restarts, or when they always fall at the end of a whole groove.
+        double restart_cycles_{ std::numeric_limits<double>::infinity() };
+
+        // The pulse width setting as a fraction of the cycle.
+        double pulse_width_{ 0.5 };
+
+        // The trigger length in milliseconds, zero when not in trigger mode.
+        double trigger_ms_{};
+
+        // The fraction of each cycle that the pulse is high, from either the
+        // pulse width or the trigger length at the current rate.
+        double width_{ 0.5 };
+
+        // The groove offset of each step in cycles, and the number of steps.
+        std::array<double, maxGrooveSteps> groove_{};
+        int groove_steps_{ 1 };
+
+        // The pattern of pulses to output, the number of steps, and the number of
+        // cycles before both the groove and pattern repeat.
+        std::uint64_t pattern_{ 1 };
+        int pattern_steps_{ 1 };
+        int period_steps_{ 1 };
 
-        // The current phase.
-        float phase_{};
+        // Whether the pattern never outputs a pulse.
+        bool silent_{ false };
 
-        // The delta to increment the phase.
-        float delta_{};
+        // The rising and falling edge of each step relative to the start of its
+        // cycle, compiled from the groove and width.
+        std::array<double, maxGrooveSteps> rise_{};
+        std::array<double, maxGrooveSteps> fall_{ 0.5 };
+
+        // Whether edges are band limited.
+        bool band_limited_{ false };
+
+        // The delta to increment the phase in cycles per sample.
+        double delta_{};
+
+        // The change in delta per sample while the tempo is ramping.
+        double delta_slope_{};
 
         // The audio sample rate.
-        float sample_rate_{};
+        double sample_rate_{};
+
+        // Where edge errors are added, if anywhere.
+        Telemetry* telemetry_{ nullptr };
+
+        // Whether the phase is moving at all during the next block.
+        bool IsRunning() const
+        {
+            return delta_ > 0.0 || delta_slope_ > 0.0;
+        }
+
+        // The number of pulse cycles per quarter note.
+        double CyclesPerQuarter() const
+        {
+            return static_cast<double>(ppqn_) * mul_ / div_;
+        }
 
         // Calculate the delta amount to increment the phase.
         void UpdateDelta();
+
+        // Build the edge table for each step of the groove.
+        void CompileGroove();
+
+        // The position of an edge, the start of its cycle and the next grid
+        // restart, in cycles relative to the phase at the start of the block.
+        struct EdgeCursor
+        {
+            double edge;
+            bool rising;
+            double cycle;
+            int step;
+            int hit;
+            double restart;
+        };
+
+        // The first edge after the sample preceding the block.
+        EdgeCursor FirstEdge() const;
+
+        // Move the cursor on to the following edge.
+        void NextEdge(EdgeCursor& cursor) const;
+
+        // Whether a step of the pattern outputs a pulse.
+        bool IsHit(int hit) const
+        {
+            return (pattern_ >> hit) & 1;
+        }
+
+        // The first step of the pattern that outputs a pulse.
+        int FirstHit() const
+        {
+            int hit = 0;
+
+            while (hit < pattern_steps_ && !IsHit(hit))
+                ++hit;
+
+            return hit;
+        }
+
+        // Move an edge that falls after a grid restart onto the restarted grid.
+        void ApplyRestart(EdgeCursor& cursor) const;
+
+        // Add the PolyBLEP correction around each edge of a rendered block.
+        template <typename SampleType>
+        void ApplyBandLimiting(SampleType* out, int num_samples) const;
+
+        // Move the phase and any tempo ramp on to the end of a block.
+        void Advance(int num_samples);
+
+        // The number of samples from the start of the block until the phase
+        // has advanced by distance cycles, or infinity if it never does.
+        double SamplesUntil(double distance) const;
     };
 }
 
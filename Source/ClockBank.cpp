@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+    File: clockbank.cpp
+    Author: Daniel Schwartz
+    Description: A set of clocks driven from a single shared timeline.
+
+  ==============================================================================
+*/
+
+#include "ClockBank.h"
+
+using namespace dingus_dsp;
+
+void ClockBank::Init(double sample_rate)
+{
+    for (auto& clock : clocks_)
+        clock.Init(sample_rate);
+}
+
+void ClockBank::SetTimeline(double tempo, double end_tempo, double ppq_position, double ppq_origin, int num_samples)
+{
+    for (auto& clock : clocks_)
+    {
+        clock.SetTempo(tempo);
+
+        if (end_tempo != tempo)
+            clock.SetTempoRamp(end_tempo, num_samples);
+
+        clock.SetPpqPosition(ppq_position, ppq_origin);
+    }
+}
+
+void ClockBank::SetRestartLength(double restart_quarters)
+{
+    for (auto& clock : clocks_)
+        clock.SetRestartLength(restart_quarters);
+}
\ No newline at end of file
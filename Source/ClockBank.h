@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    File: clockbank.h
+    Author: Daniel Schwartz
+    Description: A set of clocks driven from a single shared timeline.
+
+  ==============================================================================
+*/
+
+#pragma once
+#ifndef DINGUS_CLOCKBANK_H
+#define DINGUS_CLOCKBANK_H
+
+#include <JuceHeader.h>
+#include "Clock.h"
+
+namespace dingus_dsp
+{
+    // A set of clocks driven from a single shared timeline.
+    // The tempo, tempo ramp and host position are set once per block for every
+    // clock, each clock keeps its own rate and pulse settings.
+    class ClockBank
+    {
+    public:
+        // The number of clocks in the bank.
+        static constexpr int numClocks = 4;
+
+        ClockBank() {}
+        ~ClockBank() {}
+
+        // Initialize every clock for playback given the audio rate.
+        void Init(double sample_rate);
+
+        // Set the timeline for the next block of num_samples.  The tempo ramps
+        // linearly from tempo to end_tempo (bpm) across the block, and the pulse
+        // grid is measured from ppq_origin.
+        void SetTimeline(double tempo, double end_tempo, double ppq_position, double ppq_origin, int num_samples);
+
+        // Restart the pulse grid of every clock every restart_quarters, zero for never.
+        void SetRestartLength(double restart_quarters);
+
+        // Render a block of float or double samples from one clock in the bank.
+        template <typename SampleType>
+        void ProcessBlock(int index, SampleType* out, int num_samples)
+        {
+            clocks_[static_cast<size_t>(index)].ProcessBlock(out, num_samples);
+        }
+
+        // Access a clock to change its settings.
+        Clock& GetClock(int index)
+        {
+            return clocks_[static_cast<size_t>(index)];
+        }
+
+    private:
+        std::array<Clock, numClocks> clocks_;
+    };
+}
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+    File: clockfollower.cpp
+    Author: Daniel Schwartz
+    Description: Follows the tempo and position of an incoming audio clock.
+
+  ==============================================================================
+*/
+
+#include "ClockFollower.h"
+
+using namespace dingus_dsp;
+
+void ClockFollower::Init(double sample_rate)
+{
+    sample_rate_ = sample_rate;
+    block_start_ = 0;
+    next_block_ = 0;
+    has_next_position_ = false;
+    Reset();
+}
+
+void ClockFollower::Reset()
+{
+    high_ = false;
+    last_sample_ = 0.f;
+    first_edge_ = 0.0;
+    edge_time_ = 0.0;
+    period_ = 0.0;
+    pulses_ = 0;
+    edges_seen_ = 0;
+    steady_edges_ = 0;
+    locked_ = false;
+    lock_time_ = -1;
+    mean_square_error_ = 0.0;
+}
+
+template <typename SampleType>
+void ClockFollower::ProcessBlock(const SampleType* in, int num_samples)
+{
+    StartBlock(num_samples);
+
+    if (in != nullptr)
+    {
+        int i = 0;
+
+        while (i < num_samples)
+        {
+            // Most of a clock signal sits well above or below the thresholds, so
+            // skip whole runs of samples that cannot hold the next crossing
+            int count = juce::jmin(scan_size_, num_samples - i);
+            SampleType minimum, maximum;
+            juce::FloatVectorOperations::findMinAndMax(in + i, count, minimum, maximum);
+
+            if (high_ ? minimum > lower_ : maximum < upper_)
+            {
+                i += count;
+                continue;
+            }
+
+            for (int end = i + count; i < end; ++i)
+            {
+                if (!high_ && in[i] >= upper_)
+                {
+                    high_ = true;
+                    OnEdge(EdgeTime(in, i, upper_));
+                }
+                else if (high_ && in[i] <= lower_)
+                {
+                    high_ = false;
+                }
+            }
+        }
+
+        if (num_samples > 0)
+            last_sample_ = static_cast<float>(in[num_samples - 1]);
+    }
+
+    EndBlock();
+}
+
+template void ClockFollower::ProcessBlock<float>(const float* in, int num_samples);
+template void ClockFollower::ProcessBlock<double>(const double* in, int num_samples);
+
+void ClockFollower::EndBlock()
+{
+    // Once the pulses stop the input is treated as stopped, and the next edge
+    // starts it again from the top
+    double timeout = (edges_seen_ > 1) ? dropout_pulses_ * period_
+                                       : 60.0 * sample_rate_ / (min_tempo_ * ppqn_);
+
+    if (edges_seen_ > 0 && next_block_ - edge_time_ > timeout)
+    {
+        float level = last_sample_;
+        bool high = high_;
+        Reset();
+        last_sample_ = level;
+        high_ = high;
+    }
+}
+
+void ClockFollower::OnEdge(double time)
+{
+    ++edges_seen_;
+
+    if (edges_seen_ == 1)
+    {
+        first_edge_ = time;
+        edge_time_ = time;
+        pulses_ = 0;
+    }
+    else if (edges_seen_ == 2)
+    {
+        // The second edge gives the first estimate of the period
+        period_ = time - edge_time_;
+        edge_time_ = time;
+        ++pulses_;
+    }
+    else
+    {
+        UpdateLoop(time);
+    }
+
+    if (has_next_position_)
+    {
+        pulses_ = static_cast<juce::int64>(std::llround(next_position_ * ppqn_));
+        has_next_position_ = false;
+    }
+}
+
+void ClockFollower::UpdateLoop(double time)
+{
+    // A missed edge shows up as an error of a whole period, so count every
+    // pulse that should have happened before comparing
+    double elapsed = time - edge_time_;
+    double pulses = juce::jmax(1.0, std::round(elapsed / period_));
+    double error = elapsed - pulses * period_;
+
+    // An edge far from any predicted pulse is a change the loop cannot follow
+    // smoothly, so start measuring the period again from here
+    if (std::abs(error) > 0.25 * period_)
+    {
+        period_ = elapsed / pulses;
+        edge_time_ = time;
+        pulses_ += static_cast<juce::int64>(pulses);
+        steady_edges_ = 0;
+        locked_ = false;
+        return;
+    }
+
+    edge_time_ += pulses * period_ + alpha_ * error;
+    period_ += beta_ * error / pulses;
+    pulses_ += static_cast<juce::int64>(pulses);
+
+    // Track the jitter over roughly the last hundred edges
+    mean_square_error_ += 0.01 * (error * error - mean_square_error_);
+
+    if (std::abs(error) < lock_tolerance_ * period_)
+    {
+        if (++steady_edges_ >= lock_edges_ && !locked_)
+        {
+            locked_ = true;
+
+            if (lock_time_ < 0)
+                lock_time_ = static_cast<juce::int64>(std::ceil(time - first_edge_));
+        }
+    }
+    else
+    {
+        steady_edges_ = 0;
+    }
+}
+
+double ClockFollower::GetTempo() const
+{
+    if (period_ <= 0.0)
+        return 0.0;
+
+    return 60.0 * sample_rate_ / (period_ * ppqn_);
+}
+
+double ClockFollower::GetPpqPosition(int sample_offset) const
+{
+    if (period_ <= 0.0)
+        return 0.0;
+
+    double pulses = pulses_ + (block_start_ + sample_offset - edge_time_) / period_;
+    return pulses / ppqn_;
+}
\ No newline at end of file
@@ -0,0 +1,209 @@
+/*
+  ==============================================================================
+
+    File: clockfollower.h
+    Author: Daniel Schwartz
+    Description: Follows the tempo and position of an incoming audio clock.
+
+  ==============================================================================
+*/
+
+#pragma once
+#ifndef DINGUS_CLOCKFOLLOWER_H
+#define DINGUS_CLOCKFOLLOWER_H
+
+#include <JuceHeader.h>
+
+namespace dingus_dsp
+{
+    // Follows the tempo and position of an incoming audio or MIDI clock.
+    // Rising edges of an audio clock are found with a threshold and hysteresis
+    // and timed to a fraction of a sample, MIDI clock ticks are added directly.
+    // A phase locked loop smooths the edge times into a steady period and
+    // phase, so the clocks driven from it do not jitter with the input.  The
+    // first edge after the input starts is quarter note zero.
+    class ClockFollower
+    {
+    public:
+        ClockFollower() {}
+        ~ClockFollower() {}
+
+        // Initialize the follower given the audio rate.
+        void Init(double sample_rate);
+
+        // Forget the input clock and wait for it to start again.
+        void Reset();
+
+        // Find the edges in a block of float or double samples of the input
+        // clock and update the tempo and position.  A null input is treated as
+        // silence.
+        template <typename SampleType>
+        void ProcessBlock(const SampleType* in, int num_samples);
+
+        // Start a block of num_samples when edges are added directly.
+        void StartBlock(int num_samples)
+        {
+            block_start_ = next_block_;
+            next_block_ += num_samples;
+        }
+
+        // Add an edge at a sample offset within the block, in order.
+        void AddEdge(double sample_offset)
+        {
+            OnEdge(block_start_ + sample_offset);
+        }
+
+        // Finish the block, treating the input as stopped if it has gone quiet.
+        void EndBlock();
+
+        // Count the next edge as the given position in quarter notes, e.g.
+        // after a MIDI start or song position message.
+        void SetNextPosition(double ppq_position)
+        {
+            next_position_ = ppq_position;
+            has_next_position_ = true;
+        }
+
+        // The position in quarter notes that the next edge will count as.
+        double GetNextPosition() const
+        {
+            return has_next_position_ ? next_position_ : static_cast<double>(pulses_ + 1) / ppqn_;
+        }
+
+        // Set the pulses per quarter note of the input clock.
+        void SetPpqn(int ppqn)
+        {
+            ppqn_ = juce::jmax(1, ppqn);
+        }
+
+        // Set the level an edge must cross.  The input must fall below the
+        // threshold minus the hysteresis before another edge is found.
+        void SetThreshold(float threshold, float hysteresis)
+        {
+            upper_ = threshold;
+            lower_ = threshold - juce::jmax(0.f, hysteresis);
+        }
+
+        // Set the loop gain for phase, from 0 to 1, and the largest edge error
+        // as a fraction of the period that counts towards locking.  A lower gain
+        // smooths more jitter but takes longer to follow a tempo change.
+        void SetLoopGain(double gain, double lock_tolerance)
+        {
+            alpha_ = juce::jlimit(0.01, 1.0, gain);
+            beta_ = alpha_ * alpha_ / (2.0 - alpha_);
+            lock_tolerance_ = lock_tolerance;
+        }
+
+        // Whether the loop has locked to a steady input clock.
+        bool IsLocked() const
+        {
+            return locked_;
+        }
+
+        // The tempo of the input clock (bpm).
+        double GetTempo() const;
+
+        // The position in quarter notes at a sample offset from the start of the
+        // last block processed.
+        double GetPpqPosition(int sample_offset) const;
+
+        // The RMS difference between the detected and predicted edges in samples.
+        double GetJitter() const
+        {
+            return std::sqrt(mean_square_error_);
+        }
+
+        // The number of samples from the first edge until the loop locked, or
+        // -1 if it has not locked.
+        juce::int64 GetLockTime() const
+        {
+            return lock_time_;
+        }
+
+    private:
+        // The loop gains for phase and period.  Beta follows from alpha for a
+        // critically damped response.
+        double alpha_{ 0.25 };
+        double beta_{ 0.25 * 0.25 / 1.75 };
+
+        // The largest edge error, as a fraction of the period, that counts
+        // towards locking.
+        double lock_tolerance_{ 0.05 };
+
+        // The number of steady edges in a row needed to lock.
+        static constexpr int lock_edges_ = 4;
+
+        // The number of missing pulses before the input is treated as stopped.
+        static constexpr int dropout_pulses_ = 4;
+
+        // The slowest input tempo that can be followed (bpm).
+        static constexpr double min_tempo_ = 20.0;
+
+        // The number of samples scanned at once for a possible edge.
+        static constexpr int scan_size_ = 16;
+
+        // The audio sample rate.
+        double sample_rate_{};
+
+        // Pulses per quarter note of the input clock.
+        int ppqn_{ 24 };
+
+        // The edge thresholds.
+        float upper_{ 0.5f };
+        float lower_{ 0.4f };
+
+        // The detector state and the last input sample of the previous block.
+        bool high_{ false };
+        float last_sample_{};
+
+        // The time of the first sample of the last block processed, and of the
+        // block after it.
+        juce::int64 block_start_{};
+        juce::int64 next_block_{};
+
+        // The time of the first edge, and the loop's estimate of the last edge.
+        double first_edge_{};
+        double edge_time_{};
+
+        // The loop's estimate of the samples per pulse.
+        double period_{};
+
+        // The number of pulses since the first edge.
+        juce::int64 pulses_{};
+
+        // A position for the next edge to count as.
+        double next_position_{};
+        bool has_next_position_{ false };
+
+        // The number of edges seen since the input started.
+        int edges_seen_{};
+
+        // The number of steady edges in a row.
+        int steady_edges_{};
+
+        bool locked_{ false };
+        juce::int64 lock_time_{ -1 };
+        double mean_square_error_{};
+
+        // Count an edge at time.
+        void OnEdge(double time);
+
+        // Update the loop with an edge after the period is known.
+        void UpdateLoop(double time);
+
+        // The time of the edge crossing threshold between the sample before
+        // index and index within the current block.
+        template <typename SampleType>
+        double EdgeTime(const SampleType* in, int index, float threshold) const
+        {
+            double before = index > 0 ? static_cast<double>(in[index - 1]) : last_sample_;
+            double step = in[index] - before;
+            double fraction = step != 0.0 ? (threshold - before) / step : 1.0;
+
+            return block_start_ + index - 1 + juce::jlimit(0.0, 1.0, fraction);
+        }
+    };
+}
+
+
+#endif
\ No newline at end of file
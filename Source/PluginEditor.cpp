@@ -11,11 +11,11 @@
 
 //==============================================================================
 ClockmakerAudioProcessorEditor::ClockmakerAudioProcessorEditor (ClockmakerAudioProcessor& p, juce::AudioProcessorValueTreeState& vts)
-    : AudioProcessorEditor (&p), audioProcessor (p), parameters(vts)
+    : AudioProcessorEditor (&p), audioProcessor (p), parameters(vts), scopeView (p.getPulseScope())
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (200, 200);
+    setSize (470, 310);
 
     ppqnSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
     ppqnSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
@@ -37,6 +37,65 @@ ClockmakerAudioProcessorEditor::ClockmakerAudioProcessorEditor (ClockmakerAudioP
     mulDivLabel.attachToComponent(&mulDivSlider, false);
     addAndMakeVisible(&mulDivLabel);
 
+    widthSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
+    widthSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
+    widthAttach.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(parameters, "width", widthSlider));
+    addAndMakeVisible(&widthSlider);
+
+    widthLabel.setText("Width", juce::dontSendNotification);
+    widthLabel.setJustificationType(juce::Justification::centred);
+    widthLabel.attachToComponent(&widthSlider, false);
+    addAndMakeVisible(&widthLabel);
+
+    triggerSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
+    triggerSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
+    triggerAttach.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(parameters, "trigger", triggerSlider));
+    addAndMakeVisible(&triggerSlider);
+
+    triggerLabel.setText("Trigger", juce::dontSendNotification);
+    triggerLabel.setJustificationType(juce::Justification::centred);
+    triggerLabel.attachToComponent(&triggerSlider, false);
+    addAndMakeVisible(&triggerLabel);
+
+    swingSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
+    swingSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
+    swingAttach.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(parameters, "swing", swingSlider));
+    addAndMakeVisible(&swingSlider);
+
+    swingLabel.setText("Swing", juce::dontSendNotification);
+    swingLabel.setJustificationType(juce::Justification::centred);
+    swingLabel.attachToComponent(&swingSlider, false);
+    addAndMakeVisible(&swingLabel);
+
+    midiClockButton.setButtonText("MIDI Clock");
+    midiClockAttach.reset(new juce::AudioProcessorValueTreeState::ButtonAttachment(parameters, "midiClock", midiClockButton));
+    addAndMakeVisible(&midiClockButton);
+
+    bandLimitedButton.setButtonText("Band Limit");
+    bandLimitedAttach.reset(new juce::AudioProcessorValueTreeState::ButtonAttachment(parameters, "bandLimited", bandLimitedButton));
+    addAndMakeVisible(&bandLimitedButton);
+
+    // Items must be added before attaching so the saved choice is selected
+    syncBox.addItemList(juce::StringArray { "Host", "Input", "MIDI" }, 1);
+    syncAttach.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(parameters, "sync", syncBox));
+    addAndMakeVisible(&syncBox);
+
+    alignBox.addItemList(juce::StringArray { "Bar", "Song" }, 1);
+    alignAttach.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(parameters, "align", alignBox));
+    addAndMakeVisible(&alignBox);
+
+    statsLabel.setFont(juce::Font(12.0f));
+    statsLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(&statsLabel);
+
+    addAndMakeVisible(&scopeView);
+
+    // Only the changed controls are repainted, over the cached background
+    setOpaque(true);
+
+    lastTelemetry = audioProcessor.getTelemetry().GetSnapshot();
+    startTimerHz(2);
+
     setLookAndFeel(&style);
 }
 
@@ -48,6 +107,23 @@ ClockmakerAudioProcessorEditor::~ClockmakerAudioProcessorEditor()
 //==============================================================================
 void ClockmakerAudioProcessorEditor::paint (juce::Graphics& g)
 {
+    float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (backgroundImage.isNull() || scale != backgroundScale)
+        drawBackground (scale);
+
+    g.drawImageTransformed (backgroundImage, juce::AffineTransform::scale (1.0f / scale));
+}
+
+void ClockmakerAudioProcessorEditor::drawBackground (float scale)
+{
+    backgroundImage = juce::Image (juce::Image::RGB, juce::jmax (1, juce::roundToInt (getWidth() * scale)),
+                                   juce::jmax (1, juce::roundToInt (getHeight() * scale)), false);
+    backgroundScale = scale;
+
+    juce::Graphics g (backgroundImage);
+    g.addTransform (juce::AffineTransform::scale (scale));
+
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
 
@@ -56,18 +132,60 @@ void ClockmakerAudioProcessorEditor::paint (juce::Graphics& g)
     g.drawFittedText ("CLOCKMAKER", getLocalBounds().reduced(padding), juce::Justification::centredTop, 1);
 }
 
+void ClockmakerAudioProcessorEditor::timerCallback()
+{
+    auto telemetry = audioProcessor.getTelemetry().GetSnapshot();
+    auto recent = telemetry.Since(lastTelemetry);
+
+    // Keep showing the last figures while the host is not processing
+    if (recent.block_time.GetTotal() == 0)
+        return;
+
+    juce::String text = "Block p50 " + juce::String(recent.block_time.GetPercentile(0.5), 1) + " us"
+                      + "  p99 " + juce::String(recent.block_time.GetPercentile(0.99), 1) + " us";
+
+    if (recent.edge_error.GetTotal() > 0)
+        text += "    Edge error p99 " + juce::String(recent.edge_error.GetPercentile(0.99), 2) + " samples";
+
+    if (recent.timeline_error.GetTotal() > 0)
+        text += "    Timeline error p99 " + juce::String(recent.timeline_error.GetPercentile(0.99), 2) + " samples";
+
+    statsLabel.setText(text, juce::dontSendNotification);
+    lastTelemetry = telemetry;
+}
+
 void ClockmakerAudioProcessorEditor::resized()
 {
+    backgroundImage = {};
+
     juce::Rectangle<int> area = getLocalBounds().reduced(padding);
 
+    juce::Rectangle<int> buttonArea = area.removeFromBottom(buttonHeight);
+    scopeView.setBounds(area.removeFromBottom(scopeHeight + padding).withTrimmedTop(padding));
+    int buttonWidth = buttonArea.getWidth() / 4;
+    midiClockButton.setBounds(buttonArea.removeFromLeft(buttonWidth));
+    bandLimitedButton.setBounds(buttonArea.removeFromLeft(buttonWidth));
+    syncBox.setBounds(buttonArea.removeFromLeft(buttonWidth).reduced(0, 2));
+    alignBox.setBounds(buttonArea.reduced(0, 2));
+
     int componentWidth = area.getWidth();
     int componentHeight = area.getHeight() / 2;
 
-    area.removeFromTop(componentHeight);
+    // The stats sit under the title, above the slider labels
+    statsLabel.setBounds(area.removeFromTop(componentHeight).withTrimmedTop(44).withHeight(16));
 
     ppqnSlider.setSize(componentWidth / 2, componentHeight);
     ppqnSlider.setBoundsToFit(area.removeFromLeft(componentHeight), juce::Justification::centred, true);
 
     mulDivSlider.setSize(componentWidth / 2, componentHeight);
     mulDivSlider.setBoundsToFit(area.removeFromLeft(componentHeight), juce::Justification::centred, true);
+
+    widthSlider.setSize(componentWidth / 2, componentHeight);
+    widthSlider.setBoundsToFit(area.removeFromLeft(componentHeight), juce::Justification::centred, true);
+
+    triggerSlider.setSize(componentWidth / 2, componentHeight);
+    triggerSlider.setBoundsToFit(area.removeFromLeft(componentHeight), juce::Justification::centred, true);
+
+    swingSlider.setSize(componentWidth / 2, componentHeight);
+    swingSlider.setBoundsToFit(area.removeFromLeft(componentHeight), juce::Justification::centred, true);
 }
@@ -11,11 +11,13 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "Style.h"
+#include "ScopeView.h"
 
 //==============================================================================
 /**
 */
-class ClockmakerAudioProcessorEditor  : public juce::AudioProcessorEditor
+class ClockmakerAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                        private juce::Timer
 {
 public:
     ClockmakerAudioProcessorEditor (ClockmakerAudioProcessor&, juce::AudioProcessorValueTreeState&);
@@ -39,7 +41,47 @@ private:
     juce::Label mulDivLabel;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> mulDivAttach;
 
+    juce::Slider widthSlider;
+    juce::Label widthLabel;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> widthAttach;
+
+    juce::Slider triggerSlider;
+    juce::Label triggerLabel;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> triggerAttach;
+
+    juce::Slider swingSlider;
+    juce::Label swingLabel;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> swingAttach;
+
+    juce::ToggleButton midiClockButton;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> midiClockAttach;
+
+    juce::ToggleButton bandLimitedButton;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> bandLimitedAttach;
+
+    // Shows the block time, edge error and timeline error since the last update
+    juce::Label statsLabel;
+    dingus_dsp::Telemetry::Snapshot lastTelemetry;
+    void timerCallback() override;
+
+    // Recent pulses of every clock against the beat grid
+    dingus_dsp::ScopeView scopeView;
+
+    juce::ComboBox syncBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> syncAttach;
+
+    juce::ComboBox alignBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> alignAttach;
+
+    // The background and title only change with size or display scale, so they
+    // are drawn once into an image and copied to whatever area needs repainting
+    juce::Image backgroundImage;
+    float backgroundScale = 0.0f;
+    void drawBackground (float scale);
+
     const int padding = 10;
+    const int buttonHeight = 30;
+    const int scopeHeight = 70;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ClockmakerAudioProcessorEditor)
 };
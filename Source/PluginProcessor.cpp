@@ -18,48 +18,221 @@ ClockmakerAudioProcessor::ClockmakerAudioProcessor()
         .withInput("Input", juce::AudioChannelSet::mono(), true)
 #endif
         .withOutput("Output", juce::AudioChannelSet::mono(), true)
+        .withOutput("Clock 2", juce::AudioChannelSet::mono(), false)
+        .withOutput("Clock 3", juce::AudioChannelSet::mono(), false)
+        .withOutput("Clock 4", juce::AudioChannelSet::mono(), false)
+        .withOutput("Reset", juce::AudioChannelSet::mono(), false)
+        .withOutput("Run", juce::AudioChannelSet::mono(), false)
 #endif
     ),
 #endif
-    parameters(*this, nullptr, "parameters", { std::make_unique<juce::AudioParameterInt>("ppqn", "PPQN", 2, 96, 24),
-                                               std::make_unique<juce::AudioParameterInt>("mulDiv", "MulDiv", -8, 8, 0, juce::String(),
-                                                    [](int value, int maxLen)
-                                                    {
-                                                        if (value > 1)
-                                                        {
-                                                            return "x " + juce::String(value);
-                                                        }
-                                                        else if (value < -1)
-                                                        {
-                                                            return "/ " + juce::String(value * -1);
-                                                        }
-
-                                                        return juce::String("x 1");
-                                                    },
-                                                    [](const juce::String& text)
-                                                    {
-                                                        if (text.contains("/"))
-                                                            return text.getTrailingIntValue() * -1;
-
-                                                        return text.getTrailingIntValue();
-                                                    })
-                                              })
-{
-    parameters.addParameterListener("ppqn", this);   
-    parameters.addParameterListener("mulDiv", this);
+    parameters(*this, nullptr, "parameters", createParameterLayout())
+{
+    for (int i = 0; i < dingus_dsp::ClockBank::numClocks; ++i)
+    {
+        for (auto& name : { "ppqn", "mulDiv", "width", "trigger", "swing", "steps", "hits", "rotate" })
+        {
+            auto id = getClockParameterId(name, i);
+            parameters.addParameterListener(id, this);
+            parameterChanged(id, *parameters.getRawParameterValue(id));
+        }
+    }
+
+    for (auto& id : { juce::String("midiClock"), juce::String("bandLimited"), juce::String("offset"), juce::String("align"),
+                      juce::String("sync"), juce::String("inputPpqn"), juce::String("inputThreshold") })
+    {
+        parameters.addParameterListener(id, this);
+        parameterChanged(id, *parameters.getRawParameterValue(id));
+    }
 }
 
 ClockmakerAudioProcessor::~ClockmakerAudioProcessor()
 {
 }
 
+//==============================================================================
+juce::AudioProcessorValueTreeState::ParameterLayout ClockmakerAudioProcessor::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    // A full set of clock parameters for each clock output
+    for (int i = 0; i < dingus_dsp::ClockBank::numClocks; ++i)
+    {
+        juce::String suffix = (i == 0) ? juce::String() : " " + juce::String(i + 1);
+
+        layout.add(std::make_unique<juce::AudioParameterInt>(getClockParameterId("ppqn", i), "PPQN" + suffix, 2, 96, 24),
+                   std::make_unique<juce::AudioParameterInt>(getClockParameterId("mulDiv", i), "MulDiv" + suffix, -8, 8, 0, juce::String(),
+                        [](int value, int maxLen)
+                        {
+                            juce::ignoreUnused(maxLen);
+
+                            if (value > 1)
+                            {
+                                return "x " + juce::String(value);
+                            }
+                            else if (value < -1)
+                            {
+                                return "/ " + juce::String(value * -1);
+                            }
+
+                            return juce::String("x 1");
+                        },
+                        [](const juce::String& text)
+                        {
+                            if (text.contains("/"))
+                                return text.getTrailingIntValue() * -1;
+
+                            return text.getTrailingIntValue();
+                        }),
+                   std::make_unique<juce::AudioParameterInt>(getClockParameterId("width", i), "Width" + suffix, 1, 99, 50, "%"),
+                   std::make_unique<juce::AudioParameterFloat>(getClockParameterId("trigger", i), "Trigger" + suffix,
+                        juce::NormalisableRange<float>(0.f, 50.f, 0.1f), 0.f, "ms",
+                        juce::AudioProcessorParameter::genericParameter,
+                        [](float value, int maxLen)
+                        {
+                            juce::ignoreUnused(maxLen);
+
+                            if (value <= 0.f)
+                                return juce::String("Off");
+
+                            return juce::String(value, 1) + " ms";
+                        },
+                        [](const juce::String& text)
+                        {
+                            return text.getFloatValue();
+                        }),
+                   std::make_unique<juce::AudioParameterInt>(getClockParameterId("swing", i), "Swing" + suffix, 50, 75, 50, "%"),
+                   std::make_unique<juce::AudioParameterInt>(getClockParameterId("steps", i), "Steps" + suffix, 1, 32, 16),
+                   std::make_unique<juce::AudioParameterInt>(getClockParameterId("hits", i), "Hits" + suffix, 0, 32, 16),
+                   std::make_unique<juce::AudioParameterInt>(getClockParameterId("rotate", i), "Rotate" + suffix, 0, 31, 0));
+    }
+
+    layout.add(std::make_unique<juce::AudioParameterBool>("midiClock", "MIDI Clock", true),
+               std::make_unique<juce::AudioParameterBool>("bandLimited", "Band Limited", false),
+               std::make_unique<juce::AudioParameterFloat>("offset", "Offset", juce::NormalisableRange<float>(-50.f, 50.f, 0.1f), 0.f, "ms"),
+               std::make_unique<juce::AudioParameterChoice>("align", "Align", juce::StringArray { "Bar", "Song" }, alignBar),
+               std::make_unique<juce::AudioParameterChoice>("sync", "Sync", juce::StringArray { "Host", "Input", "MIDI" }, syncHost),
+               std::make_unique<juce::AudioParameterInt>("inputPpqn", "Input PPQN", 1, 96, 24),
+               std::make_unique<juce::AudioParameterFloat>("inputThreshold", "Input Threshold", juce::NormalisableRange<float>(0.05f, 0.95f, 0.01f), 0.25f));
+
+    return layout;
+}
+
+juce::String ClockmakerAudioProcessor::getClockParameterId(const juce::String& name, int index)
+{
+    // The first clock keeps the original IDs so existing sessions still load
+    return (index == 0) ? name : name + juce::String(index + 1);
+}
+
 //==============================================================================
 void ClockmakerAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
 {
-    if (parameterID == "ppqn")
-        dingusClock.SetPpqn(static_cast<int> (newValue));
-    else if (parameterID == "mulDiv")
-        dingusClock.SetMulDiv(static_cast<int> (newValue));
+    // This may be called from any thread, so only publish the value here.
+    // The clocks themselves are updated by applyClockParameters on the audio thread.
+    if (parameterID == "midiClock")
+    {
+        midiClockEnabled.store(newValue >= 0.5f, std::memory_order_relaxed);
+        return;
+    }
+
+    if (parameterID == "bandLimited")
+    {
+        bandLimitedEnabled.store(newValue >= 0.5f, std::memory_order_relaxed);
+        return;
+    }
+
+    if (parameterID == "offset")
+    {
+        // The reported latency can only be changed from the message thread
+        offsetMs.store(newValue, std::memory_order_relaxed);
+        triggerAsyncUpdate();
+        return;
+    }
+
+    if (parameterID == "align")
+    {
+        alignMode.store(static_cast<int> (newValue), std::memory_order_relaxed);
+        return;
+    }
+
+    if (parameterID == "sync")
+    {
+        syncSource.store(static_cast<int> (newValue), std::memory_order_relaxed);
+        return;
+    }
+
+    if (parameterID == "inputPpqn")
+    {
+        inputPpqn.store(static_cast<int> (newValue), std::memory_order_relaxed);
+        return;
+    }
+
+    if (parameterID == "inputThreshold")
+    {
+        inputThreshold.store(newValue, std::memory_order_relaxed);
+        return;
+    }
+
+    for (int i = 0; i < dingus_dsp::ClockBank::numClocks; ++i)
+    {
+        auto& values = clockParameters[static_cast<size_t> (i)];
+
+        if (parameterID == getClockParameterId("ppqn", i))
+            values.ppqn.store(static_cast<int> (newValue), std::memory_order_relaxed);
+        else if (parameterID == getClockParameterId("mulDiv", i))
+            values.mulDiv.store(static_cast<int> (newValue), std::memory_order_relaxed);
+        else if (parameterID == getClockParameterId("width", i))
+            values.width.store(newValue, std::memory_order_relaxed);
+        else if (parameterID == getClockParameterId("trigger", i))
+            values.trigger.store(newValue, std::memory_order_relaxed);
+        else if (parameterID == getClockParameterId("swing", i))
+            values.swing.store(static_cast<int> (newValue), std::memory_order_relaxed);
+        else if (parameterID == getClockParameterId("steps", i))
+            values.steps.store(static_cast<int> (newValue), std::memory_order_relaxed);
+        else if (parameterID == getClockParameterId("hits", i))
+            values.hits.store(static_cast<int> (newValue), std::memory_order_relaxed);
+        else if (parameterID == getClockParameterId("rotate", i))
+            values.rotate.store(static_cast<int> (newValue), std::memory_order_relaxed);
+        else
+            continue;
+
+        // Flag the clock once the new value is in place
+        values.changed.store(true, std::memory_order_release);
+        return;
+    }
+}
+
+void ClockmakerAudioProcessor::applyFollowerParameters()
+{
+    inputFollower.SetPpqn(inputPpqn.load(std::memory_order_relaxed));
+    inputFollower.SetThreshold(inputThreshold.load(std::memory_order_relaxed), inputHysteresis);
+}
+
+void ClockmakerAudioProcessor::applyClockParameters()
+{
+    bool bandLimited = bandLimitedEnabled.load(std::memory_order_relaxed);
+
+    // Setting a clock's rate or pulses recompiles its edge tables, so only the
+    // clocks with a changed value are set
+    for (int i = 0; i < dingus_dsp::ClockBank::numClocks; ++i)
+    {
+        auto& clock = clockBank.GetClock(i);
+        auto& values = clockParameters[static_cast<size_t> (i)];
+
+        clock.SetBandLimited(bandLimited);
+
+        if (! values.changed.exchange(false, std::memory_order_acquire))
+            continue;
+
+        clock.SetPpqn(values.ppqn.load(std::memory_order_relaxed));
+        clock.SetMulDiv(values.mulDiv.load(std::memory_order_relaxed));
+        clock.SetPulseWidth(values.width.load(std::memory_order_relaxed) * 0.01);
+        clock.SetTriggerLength(values.trigger.load(std::memory_order_relaxed));
+        clock.SetSwing(values.swing.load(std::memory_order_relaxed) * 0.01);
+        clock.SetEuclidean(values.hits.load(std::memory_order_relaxed),
+                           values.steps.load(std::memory_order_relaxed),
+                           values.rotate.load(std::memory_order_relaxed));
+    }
 }
 
 //==============================================================================
@@ -113,23 +286,76 @@ int ClockmakerAudioProcessor::getCurrentProgram()
 
 void ClockmakerAudioProcessor::setCurrentProgram (int index)
 {
+    juce::ignoreUnused (index);
 }
 
 const juce::String ClockmakerAudioProcessor::getProgramName (int index)
 {
+    juce::ignoreUnused (index);
     return {};
 }
 
 void ClockmakerAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    juce::ignoreUnused (index, newName);
 }
 
 //==============================================================================
 void ClockmakerAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    dingusClock.Init (sampleRate);
-    parameterChanged("ppqn", *parameters.getRawParameterValue("ppqn"));
-    parameterChanged("mulDiv", *parameters.getRawParameterValue("mulDiv"));
+    juce::ignoreUnused (samplesPerBlock);
+    clockBank.Init (sampleRate);
+
+    // MIDI clock always runs at 24 pulses per quarter note
+    midiClock.Init (sampleRate);
+    midiClock.SetPpqn (midiClockPpqn);
+    midiClock.SetMulDiv (1);
+
+    // Record where every output edge lands against its exact time
+    for (int i = 0; i < dingus_dsp::ClockBank::numClocks; ++i)
+        clockBank.GetClock (i).SetTelemetry (&telemetry);
+
+    midiClock.SetTelemetry (&telemetry);
+
+    inputFollower.Init (sampleRate);
+    pulseScope.Init (sampleRate);
+
+    midiFollower.Init (sampleRate);
+    midiFollower.SetPpqn (midiClockPpqn);
+    midiFollower.SetLoopGain (midiLoopGain, midiLockTolerance);
+    midiRunning = false;
+    midiRunPending = false;
+    midiResumePosition = 0.0;
+    midiStartPending = false;
+    midiTransportRunning = false;
+
+    // Reserve space for the MIDI output so events can be added without allocating
+    midiOutput.ensureSize (maxMidiClockEvents * 8);
+    midiOutputWithHost = false;
+
+    // Apply the current values to the freshly initialized clocks
+    for (auto& values : clockParameters)
+        values.changed.store (true, std::memory_order_relaxed);
+
+    applyFollowerParameters();
+    applyClockParameters();
+    updateLatency();
+}
+
+void ClockmakerAudioProcessor::handleAsyncUpdate()
+{
+    updateLatency();
+}
+
+void ClockmakerAudioProcessor::updateLatency()
+{
+    // The host may block or allocate when the latency changes
+    dingus_dsp::RealtimeCheck::AssertNotRealtime();
+
+    // A positive offset is reported to the host as latency so that hosts with delay
+    // compensation send the clock out ahead of the other tracks by that amount
+    double offsetSamples = offsetMs.load(std::memory_order_relaxed) * 0.001 * getSampleRate();
+    setLatencySamples(juce::jmax(0, juce::roundToInt(offsetSamples)));
 }
 
 void ClockmakerAudioProcessor::releaseResources()
@@ -145,17 +371,22 @@ bool ClockmakerAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
+    // Each clock is rendered once and copied to every channel of its bus, so any
+    // discrete layout up to maxOutputChannels costs the same to generate.
+    // The main output must be enabled, the extra clock outputs may be disabled.
+    for (int bus = 0; bus < layouts.outputBuses.size(); ++bus)
+    {
+        auto numOutputChannels = layouts.getNumChannels (false, bus);
+
+        if ((bus == 0 && numOutputChannels < 1) || numOutputChannels > maxOutputChannels)
+            return false;
+    }
 
-    // This checks if the input layout matches the output layout
+    // Only the first input channel is followed, so the input may be disabled, mono or match the output
    #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+    if (! layouts.getMainInputChannelSet().isDisabled()
+     && layouts.getMainInputChannelSet() != juce::AudioChannelSet::mono()
+     && layouts.getMainInputChannelSet() != layouts.getMainOutputChannelSet())
         return false;
    #endif
 
@@ -164,39 +395,549 @@ bool ClockmakerAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
 }
 #endif
 
+bool ClockmakerAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    // The clocks render either precision directly, so a 64-bit host needs no conversion
+    return true;
+}
+
 void ClockmakerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process (buffer, midiMessages);
+}
+
+void ClockmakerAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process (buffer, midiMessages);
+}
+
+void ClockmakerAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processBypassed (buffer, midiMessages);
+}
+
+void ClockmakerAudioProcessor::processBlockBypassed (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processBypassed (buffer, midiMessages);
+}
+
+template <typename SampleType>
+void ClockmakerAudioProcessor::process (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    dingus_dsp::RealtimeCheck::ScopedRealtime realtimeCheck;
+    dingus_dsp::Telemetry::ScopedBlockTimer blockTimer (telemetry);
+    auto numSamples = buffer.getNumSamples();
+
+    // The follower may read the transport from the input, so its settings are
+    // needed even when nothing will be rendered
+    applyFollowerParameters();
+    bool isPlaying = readTransport (buffer, midiMessages);
+
+    // Once the block with the stop has been rendered there is nothing left to do
+    // until the transport moves again, so skip the timeline entirely.  The host's
+    // buffer may hold input or stale data, so it is still cleared, which also
+    // marks it as silent.
+    if (! isPlaying && ! wasPlaying && ! bypassedStop)
+    {
+        buffer.clear();
+        midiMessages.clear();
+        return;
+    }
+
+    // Pick up any clock parameter changes now the block will be rendered
+    applyClockParameters();
+
+    // A stop and start while bypassed are both handled here, the stop first
+    bool transportStarted = isPlaying && (! wasPlaying || bypassedStart);
+    bool transportStopped = (wasPlaying && ! isPlaying) || bypassedStop;
+    double bpm = currentPositionInfo.bpm;
+    double ppqPosition = currentPositionInfo.ppqPosition;
+    double sampleRate = getSampleRate();
+    double samplesPerQuarter = isPlaying ? 60.0 * sampleRate / bpm : 0.0;
+
+    // The playhead only reports the tempo at the start of the block, so estimate the
+    // tempo change per sample from the previous block.  A ramp is only assumed once the
+    // tempo has moved the same way over two blocks so a single step is not extrapolated.
+    double tempoSlope = (wasPlaying && lastNumSamples > 0) ? (bpm - lastBpm) / lastNumSamples : 0.0;
+    bool isRamping = isPlaying && tempoSlope * lastTempoSlope > 0.0;
+
+    // A position that does not follow on from the previous block is a locate, or a
+    // loop wrap that the host placed on the block boundary
+    double timelineError = std::abs (ppqPosition - expectedPpqPosition) * samplesPerQuarter;
+    bool positionJumped = isPlaying && wasPlaying && (bypassedJump || timelineError > jumpToleranceMs * 0.001 * sampleRate);
+    bypassedStart = bypassedStop = bypassedJump = false;
+
+    // Anything short of a jump is error in the previous block's edges
+    if (isPlaying && wasPlaying && ! positionJumped)
+        telemetry.AddTimelineError (timelineError);
+
+    // A loop end inside the block splits it at the first sample past the loop end,
+    // where the timeline continues from the loop start
+    int wrapSample = numSamples;
+    double wrapPpqPosition = 0.0;
+
+    if (isPlaying && currentPositionInfo.isLooping
+     && currentPositionInfo.ppqLoopEnd > currentPositionInfo.ppqLoopStart
+     && ppqPosition < currentPositionInfo.ppqLoopEnd)
+    {
+        double samplesToLoopEnd = (currentPositionInfo.ppqLoopEnd - ppqPosition) * samplesPerQuarter;
+
+        if (samplesToLoopEnd < numSamples)
+        {
+            wrapSample = static_cast<int> (std::ceil (samplesToLoopEnd));
+            wrapPpqPosition = currentPositionInfo.ppqLoopStart + (wrapSample - samplesToLoopEnd) / samplesPerQuarter;
+            isRamping = false;
+        }
+    }
+
+    double endBpm = isRamping ? juce::jmax (0.0, bpm + tempoSlope * numSamples) : bpm;
+
+    if (wrapSample < numSamples)
+        expectedPpqPosition = wrapPpqPosition + (numSamples - wrapSample) / samplesPerQuarter;
+    else if (isPlaying)
+        expectedPpqPosition = ppqPosition + numSamples * 0.5 * (bpm + endBpm) / (60.0 * sampleRate);
+
+    lastBpm = bpm;
+    lastTempoSlope = tempoSlope;
+    lastNumSamples = numSamples;
+    wasPlaying = isPlaying;
 
-    // Clear the buffers for saftey.  If playhead is not moving this will set output to 0.
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
+    // Divided clocks may not fit a whole number of pulses into a bar, so in Bar mode
+    // their grid restarts on every bar line, measured from the host's last bar start.
+    // Hosts that do not report it, or report a stale value, count bars from zero.
+    double barLength = 4.0;
 
-    this->getPlayHead()->getCurrentPosition(currentPositionInfo);
-    dingusClock.SetTempo(currentPositionInfo.bpm);
+    if (currentPositionInfo.timeSigNumerator > 0 && currentPositionInfo.timeSigDenominator > 0)
+        barLength = 4.0 * currentPositionInfo.timeSigNumerator / currentPositionInfo.timeSigDenominator;
 
-    // Interpolate the number of samples that have passed since the last downbeat
-    double samplesPerQuarter = (60.0 / currentPositionInfo.bpm) * this->getSampleRate();
-    double positionFrac = currentPositionInfo.ppqPosition - static_cast<int>(currentPositionInfo.ppqPosition);
-    double sampleOffset = positionFrac * samplesPerQuarter;
+    bool alignToBars = alignMode.load (std::memory_order_relaxed) == alignBar;
+    double lastBarStart = currentPositionInfo.ppqPositionOfLastBarStart;
+    bool hasBarStart = lastBarStart <= ppqPosition && ppqPosition - lastBarStart < barLength;
 
-    if (currentPositionInfo.isPlaying || currentPositionInfo.isRecording)
+    gridOrigin = (alignToBars && hasBarStart) ? lastBarStart : 0.0;
+    clockBank.SetRestartLength (alignToBars ? barLength : 0.0);
+
+    // Any part of the offset not covered by the reported latency moves the clock
+    // along the timeline.  The clocks are computed from the position, so looking
+    // ahead or behind the playhead needs no buffering.
+    double offsetSamples = offsetMs.load (std::memory_order_relaxed) * 0.001 * sampleRate - getLatencySamples();
+    double offsetPpq = isPlaying ? offsetSamples / samplesPerQuarter : 0.0;
+
+    // Build the MIDI output in a pre-reserved buffer and swap it in, so the host's
+    // buffer is never grown on the audio thread.  Hosts reuse their buffer, so
+    // the storage handed over last block is taken back once the input is read,
+    // rather than building in whatever storage the host swapped out.
+    if (midiOutputWithHost)
+        midiMessages.swapWith (midiOutput);
+
+    midiOutput.clear();
+    addMidiTransportMessages (transportStopped, -1);
+
+    if (isPlaying)
     {
-        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        // Send a reset at the start of playback, after a locate and at the loop wrap,
+        // once the clocks reach the position playback started from
+        TransportEdges edges;
+        edges.runStart = runStarted ? 0 : numSamples;
+
+        if (transportStarted || positionJumped)
         {
-            // Advance the clock position given the number of samples since the last downbeat
-            dingusClock.SetTimeAdvance (sampleOffset);
+            playStartPosition = ppqPosition;
+            resetPending = true;
+            runStarted = runStarted && ! transportStarted;
+        }
 
-            auto* channelData = buffer.getWritePointer (channel);
+        renderSegment (buffer, 0, wrapSample, bpm, endBpm, ppqPosition + offsetPpq, samplesPerQuarter, edges);
+
+        if (wrapSample < numSamples)
+        {
+            playStartPosition = currentPositionInfo.ppqLoopStart;
+            resetPending = true;
+            renderSegment (buffer, wrapSample, numSamples - wrapSample, bpm, bpm, wrapPpqPosition + offsetPpq, samplesPerQuarter, edges);
+        }
+
+        renderTransport (buffer, edges);
+        updatePulseScope (buffer, ppqPosition + offsetPpq, samplesPerQuarter);
+    }
+    else
+    {
+        // If the playhead is not moving the output is silent
+        buffer.clear();
+        resetSamplesRemaining = 0;
+        resetPending = false;
+        runStarted = false;
+    }
+
+    midiMessages.swapWith (midiOutput);
+    midiOutputWithHost = true;
+}
 
-            for (int i = 0; i < buffer.getNumSamples(); i++)
+template <typename SampleType>
+void ClockmakerAudioProcessor::processBypassed (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ScopedNoDenormals noDenormals;
+    dingus_dsp::RealtimeCheck::ScopedRealtime realtimeCheck;
+
+    // The clocks are worked out from the timeline, so there is no phase to keep
+    // while bypassed.  Only the transport is followed, so when the bypass is
+    // released during steady playback the outputs carry on in step without a
+    // reset or MIDI start.  A start, stop or jump is noted for the first
+    // rendered block to send.  The clock parameters are left until then too.
+    applyFollowerParameters();
+    bool isPlaying = readTransport (buffer, midiMessages);
+    auto numSamples = buffer.getNumSamples();
+    double sampleRate = getSampleRate();
+
+    if (isPlaying && wasPlaying)
+    {
+        double timelineError = std::abs (currentPositionInfo.ppqPosition - expectedPpqPosition) * 60.0 * sampleRate / currentPositionInfo.bpm;
+        bypassedJump = bypassedJump || timelineError > jumpToleranceMs * 0.001 * sampleRate;
+    }
+    else if (isPlaying)
+    {
+        bypassedStart = true;
+    }
+    else if (wasPlaying)
+    {
+        // Anything before the stop is overtaken by it
+        bypassedStop = true;
+        bypassedStart = false;
+        bypassedJump = false;
+    }
+
+    if (isPlaying)
+        expectedPpqPosition = currentPositionInfo.ppqPosition + numSamples * currentPositionInfo.bpm / (60.0 * sampleRate);
+
+    lastBpm = currentPositionInfo.bpm;
+    lastTempoSlope = 0.0;
+    lastNumSamples = numSamples;
+    wasPlaying = isPlaying;
+    resetSamplesRemaining = 0;
+
+    buffer.clear();
+    midiMessages.clear();
+}
+
+template <typename SampleType>
+bool ClockmakerAudioProcessor::readTransport (juce::AudioBuffer<SampleType>& buffer, const juce::MidiBuffer& midiMessages)
+{
+    // Without a playhead (e.g. an offline harness that has not called setPlayHead)
+    // fall back to a stopped transport rather than dereferencing null
+    auto* playHead = this->getPlayHead();
+
+    if (playHead == nullptr || ! playHead->getCurrentPosition(currentPositionInfo))
+        currentPositionInfo.resetToDefault();
+
+    auto sync = syncSource.load (std::memory_order_relaxed);
+
+    if (sync == syncInput)
+        followInputClock (buffer);
+    else if (sync == syncMidi)
+        followMidiClock (midiMessages, buffer.getNumSamples());
+
+    return (currentPositionInfo.isPlaying || currentPositionInfo.isRecording) && currentPositionInfo.bpm > 0.0;
+}
+
+template <typename SampleType>
+void ClockmakerAudioProcessor::followInputClock (juce::AudioBuffer<SampleType>& buffer)
+{
+    // The input shares channels with the output, so it must be read before any
+    // clocks are rendered.  A disabled input bus is followed as silence.
+    auto input = getBusBuffer (buffer, true, 0);
+    inputFollower.ProcessBlock (input.getNumChannels() > 0 ? input.getReadPointer (0) : nullptr, buffer.getNumSamples());
+
+    // An audio clock has no transport messages, so it plays from quarter note
+    // zero at its first pulse
+    setFollowedPosition (inputFollower, true);
+}
+
+void ClockmakerAudioProcessor::followMidiClock (const juce::MidiBuffer& midiMessages, int numSamples)
+{
+    // Only the status and data bytes are read in place, so nothing is copied or
+    // allocated.  Ticks keep the loop locked while stopped, so playback starts
+    // in time on the first tick after a start.
+    midiFollower.StartBlock (numSamples);
+
+    for (const auto metadata : midiMessages)
+    {
+        if (metadata.numBytes < 1)
+            continue;
+
+        switch (metadata.data[0])
+        {
+            case 0xf8: // Timing clock
+                midiFollower.AddEdge (metadata.samplePosition);
+                midiRunning = midiRunning || midiRunPending;
+                midiRunPending = false;
+                break;
+
+            case 0xfa: // Start
+                midiFollower.SetNextPosition (0.0);
+                midiRunPending = true;
+                break;
+
+            case 0xfb: // Continue
+                midiFollower.SetNextPosition (midiResumePosition);
+                midiRunPending = true;
+                break;
+
+            case 0xfc: // Stop
+                midiResumePosition = midiFollower.GetNextPosition();
+                midiRunning = false;
+                midiRunPending = false;
+                break;
+
+            case 0xf2: // Song position, in 16th notes
+                if (metadata.numBytes >= 3)
+                    midiResumePosition = (metadata.data[1] | (metadata.data[2] << 7)) * 0.25;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    midiFollower.EndBlock();
+    setFollowedPosition (midiFollower, midiRunning);
+}
+
+void ClockmakerAudioProcessor::setFollowedPosition (const dingus_dsp::ClockFollower& follower, bool isRunning)
+{
+    // A followed clock is in 4/4 and counts as stopped until the follower has locked
+    currentPositionInfo.resetToDefault();
+
+    if (isRunning && follower.IsLocked())
+    {
+        currentPositionInfo.isPlaying = true;
+        currentPositionInfo.bpm = follower.GetTempo();
+        currentPositionInfo.ppqPosition = follower.GetPpqPosition (0);
+        currentPositionInfo.ppqPositionOfLastBarStart = std::floor (currentPositionInfo.ppqPosition / 4.0) * 4.0;
+    }
+}
+
+void ClockmakerAudioProcessor::setTimeline (double bpm, double endBpm, double ppqPosition, int numSamples)
+{
+    // Every clock output and the MIDI clock share the same tempo and position
+    clockBank.SetTimeline (bpm, endBpm, ppqPosition, gridOrigin, numSamples);
+
+    midiClock.SetTempo (bpm);
+
+    if (endBpm != bpm)
+        midiClock.SetTempoRamp (endBpm, numSamples);
+
+    // MIDI clock is always a whole number of ticks per quarter note, so it needs no bar alignment
+    midiClock.SetPpqPosition (ppqPosition, 0.0);
+    midiClockPosition = ppqPosition;
+    midiClockSamplesPerQuarter = 60.0 * getSampleRate() / bpm;
+}
+
+template <typename SampleType>
+void ClockmakerAudioProcessor::renderSegment (juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples, double bpm, double endBpm,
+                                              double ppqPosition, double samplesPerQuarter, TransportEdges& edges)
+{
+    setTimeline (bpm, endBpm, ppqPosition, numSamples);
+
+    // The host never played the part of the timeline before the start, so the
+    // outputs stay silent until the clocks reach it
+    double samplesToStart = dingus_dsp::Clock::EdgeSample ((playStartPosition - ppqPosition) * samplesPerQuarter);
+    int firstSample = static_cast<int> (juce::jlimit (0.0, static_cast<double> (numSamples), samplesToStart));
+
+    if (firstSample < numSamples)
+    {
+        // MIDI devices count on from their own position, so a start, locate or
+        // loop wrap also moves them to the new song position
+        if (resetPending)
+        {
+            if (edges.numResets < maxResetsPerBlock)
+                edges.resets[static_cast<size_t> (edges.numResets++)] = startSample + firstSample;
+
+            addMidiTransportMessages (false, startSample + firstSample);
+        }
+
+        if (! runStarted)
+            edges.runStart = startSample + firstSample;
+
+        resetPending = false;
+        runStarted = true;
+    }
+
+    renderClocks (buffer, startSample, numSamples, firstSample);
+}
+
+template <typename SampleType>
+void ClockmakerAudioProcessor::renderClocks (juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples, int mutedSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    // Each output bus carries one clock from the bank.  Only clocks with an
+    // enabled bus are rendered, once, and copied to the bus's other channels.
+    auto numBuses = juce::jmin (getBusCount (false), dingus_dsp::ClockBank::numClocks);
+
+    for (int bus = 0; bus < numBuses; ++bus)
+    {
+        auto busBuffer = getBusBuffer (buffer, false, bus);
+
+        if (busBuffer.getNumChannels() == 0)
+            continue;
+
+        // The scope shows each pulse at its exact time, which is read from the
+        // schedule before rendering moves the clock past it
+        if (pulseScope.IsEnabled())
+        {
+            int numEdges = clockBank.GetClock (bus).GetEdges (scopeEdges.data(), maxScopeEdges, numSamples);
+
+            for (int i = 0; i < numEdges; ++i)
+            {
+                auto& edge = scopeEdges[static_cast<size_t> (i)];
+
+                if (edge.rising && edge.offset >= mutedSamples)
+                    pulseScope.AddEdge (bus, startSample + edge.offset - edge.error);
+            }
+        }
+
+        auto* clockData = busBuffer.getWritePointer (0, startSample);
+        clockBank.ProcessBlock (bus, clockData, numSamples);
+        juce::FloatVectorOperations::clear (clockData, mutedSamples);
+
+        for (int channel = 1; channel < busBuffer.getNumChannels(); ++channel)
+            juce::FloatVectorOperations::copy (busBuffer.getWritePointer (channel, startSample), clockData, numSamples);
+    }
+
+    if (midiClockEnabled.load (std::memory_order_relaxed))
+    {
+        // Each MIDI clock tick is the start of a pulse
+        int numEdges = midiClock.ProcessEdges (midiClockEdges.data(), static_cast<int> (midiClockEdges.size()), numSamples);
+
+        for (int i = 0; i < numEdges; ++i)
+        {
+            auto& edge = midiClockEdges[static_cast<size_t> (i)];
+
+            if (! edge.rising || edge.offset < mutedSamples)
+                continue;
+
+            if (midiStartPending)
             {
-                channelData[i] = dingusClock.Process();
+                // The tick's exact position, rounded to the 24 PPQN grid.  Ticks before
+                // the song start or between 16th notes are held back.
+                double tickPosition = midiClockPosition + (edge.offset - edge.error) / midiClockSamplesPerQuarter;
+                auto tick = static_cast<juce::int64> (std::llround (tickPosition * midiClockPpqn));
+
+                if (tick < 0 || tick % ticksPerSongPosition != 0)
+                    continue;
+
+                auto songPosition = static_cast<int> (juce::jmin<juce::int64> (tick / ticksPerSongPosition, maxSongPosition));
+                midiOutput.addEvent (juce::MidiMessage::songPositionPointer (songPosition), startSample + edge.offset);
+                midiOutput.addEvent (songPosition == 0 ? juce::MidiMessage::midiStart() : juce::MidiMessage::midiContinue(),
+                                     startSample + edge.offset);
+                midiStartPending = false;
+                midiTransportRunning = true;
             }
+
+            midiOutput.addEvent (juce::MidiMessage::midiClock(), startSample + edge.offset);
+        }
+    }
+}
+
+template <typename SampleType>
+void ClockmakerAudioProcessor::updatePulseScope (juce::AudioBuffer<SampleType>& buffer, double ppqPosition, double samplesPerQuarter)
+{
+    // The scope is only for display, so the beat grid ignores tempo ramps and
+    // loop wraps within the block.  Nothing is read while the editor is closed.
+    std::array<const SampleType*, dingus_dsp::PulseScope::numTraces> traces {};
+
+    if (pulseScope.IsEnabled())
+    {
+        auto numBuses = juce::jmin (getBusCount (false), dingus_dsp::ClockBank::numClocks);
+
+        for (int bus = 0; bus < numBuses; ++bus)
+        {
+            auto busBuffer = getBusBuffer (buffer, false, bus);
+
+            if (busBuffer.getNumChannels() > 0)
+                traces[static_cast<size_t> (bus)] = busBuffer.getReadPointer (0);
         }
     }
+
+    pulseScope.ProcessBlock (traces.data(), buffer.getNumSamples(), ppqPosition, 1.0 / samplesPerQuarter);
+}
+
+template <typename SampleType>
+void ClockmakerAudioProcessor::renderTransport (juce::AudioBuffer<SampleType>& buffer, const TransportEdges& edges)
+{
+    auto numSamples = buffer.getNumSamples();
+
+    // The run output is high for as long as the transport is playing, from when
+    // the clocks start
+    if (runBusIndex < getBusCount (false))
+    {
+        auto runBuffer = getBusBuffer (buffer, false, runBusIndex);
+        auto runStart = juce::jlimit (0, numSamples, edges.runStart);
+
+        for (int channel = 0; channel < runBuffer.getNumChannels(); ++channel)
+        {
+            juce::FloatVectorOperations::clear (runBuffer.getWritePointer (channel), runStart);
+            juce::FloatVectorOperations::fill (runBuffer.getWritePointer (channel) + runStart, SampleType (1), numSamples - runStart);
+        }
+    }
+
+    // The reset output is a fixed length trigger, which may carry over from the previous block
+    int resetPulseSamples = juce::roundToInt (resetPulseMs * 0.001 * getSampleRate());
+    std::array<juce::Range<int>, maxResetsPerBlock + 1> resetSpans;
+    size_t numSpans = 0;
+
+    if (resetSamplesRemaining > 0)
+        resetSpans[numSpans++] = { 0, resetSamplesRemaining };
+
+    for (size_t i = 0; i < static_cast<size_t> (edges.numResets); ++i)
+        resetSpans[numSpans++] = { edges.resets[i], edges.resets[i] + resetPulseSamples };
+
+    resetSamplesRemaining = 0;
+
+    for (size_t i = 0; i < numSpans; ++i)
+        resetSamplesRemaining = juce::jmax (resetSamplesRemaining, resetSpans[i].getEnd() - numSamples);
+
+    if (resetBusIndex < getBusCount (false))
+    {
+        auto resetBuffer = getBusBuffer (buffer, false, resetBusIndex);
+
+        for (int channel = 0; channel < resetBuffer.getNumChannels(); ++channel)
+        {
+            auto* resetData = resetBuffer.getWritePointer (channel);
+            juce::FloatVectorOperations::clear (resetData, numSamples);
+
+            for (size_t i = 0; i < numSpans; ++i)
+            {
+                auto span = resetSpans[i].getIntersectionWith ({ 0, numSamples });
+
+                if (! span.isEmpty())
+                    juce::FloatVectorOperations::fill (resetData + span.getStart(), SampleType (1), span.getLength());
+            }
+        }
+    }
+}
+
+void ClockmakerAudioProcessor::addMidiTransportMessages (bool transportStopped, int restartSample)
+{
+    if (! midiClockEnabled.load (std::memory_order_relaxed))
+    {
+        midiStartPending = false;
+        midiTransportRunning = false;
+        return;
+    }
+
+    if (! transportStopped && restartSample < 0)
+        return;
+
+    // Nothing was started if the stop or restart came before the first 16th note
+    if (midiTransportRunning)
+        midiOutput.addEvent (juce::MidiMessage::midiStop(), juce::jmax (0, restartSample));
+
+    // The song position is taken from the first tick sent, which is only known
+    // once the offset has been applied to the MIDI clock
+    midiTransportRunning = false;
+    midiStartPending = ! transportStopped;
 }
 
 //==============================================================================
@@ -213,18 +954,45 @@ juce::AudioProcessorEditor* ClockmakerAudioProcessor::createEditor()
 //==============================================================================
 void ClockmakerAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
+    // The state is written as a tagged, versioned binary value tree, which is
+    // smaller than XML and loads without any text parsing
     auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    juce::MemoryOutputStream stream (destData, false);
+
+    stream.writeInt (stateChunkId);
+    stream.writeInt (stateVersion);
+    state.writeToStream (stream);
 }
 
 void ClockmakerAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    std::unique_ptr<juce::XmlElement> xml (getXmlFromBinary (data, sizeInBytes));
+    juce::ValueTree state;
+
+    if (sizeInBytes >= stateHeaderSize && static_cast<int> (juce::ByteOrder::littleEndianInt (data)) == stateChunkId)
+    {
+        // Each version only adds to the end of the tree, so any version up to this
+        // one can be read.  A newer format may not mean the same thing, so it is
+        // ignored and the current settings are kept.
+        auto version = static_cast<int> (juce::ByteOrder::littleEndianInt (static_cast<const char*> (data) + 4));
+
+        if (version < 1 || version > stateVersion)
+            return;
+
+        juce::MemoryInputStream stream (data, static_cast<size_t> (sizeInBytes), false);
+        stream.skipNextBytes (stateHeaderSize);
+        state = juce::ValueTree::readFromStream (stream);
+    }
+    else
+    {
+        // Sessions saved before the binary format hold XML
+        std::unique_ptr<juce::XmlElement> xml (getXmlFromBinary (data, sizeInBytes));
+
+        if (xml.get() != nullptr)
+            state = juce::ValueTree::fromXml (*xml);
+    }
 
-    if (xml.get() != nullptr)
-        if (xml->hasTagName (parameters.state.getType()))
-            parameters.replaceState (juce::ValueTree::fromXml (*xml));
+    if (state.hasType (parameters.state.getType()))
+        parameters.replaceState (state);
 }
 
 //==============================================================================
@@ -10,12 +10,18 @@
 
 #include <JuceHeader.h>
 #include "Clock.h"
+#include "ClockBank.h"
+#include "ClockFollower.h"
+#include "PulseScope.h"
+#include "RealtimeCheck.h"
+#include "Telemetry.h"
 
 //==============================================================================
 /**
 */
 class ClockmakerAudioProcessor  : public juce::AudioProcessor,
-                                  public juce::AudioProcessorValueTreeState::Listener
+                                  public juce::AudioProcessorValueTreeState::Listener,
+                                  private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -30,7 +36,12 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
 
+    bool supportsDoublePrecisionProcessing() const override;
+
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -58,11 +69,237 @@ public:
     // callback for when a parameter is changed, inherited from vts listener
     void parameterChanged(const juce::String& parameterID, float newValue) override;
 
+    // Block timing and accuracy statistics, safe to read from any thread
+    const dingus_dsp::Telemetry& getTelemetry() const { return telemetry; }
+
+    // Recent clock output for the editor's scope, which enables it while open
+    dingus_dsp::PulseScope& getPulseScope() { return pulseScope; }
+
 private:
     //==============================================================================
+    // The widest output bus supported, every channel of a bus carries the same clock
+    static constexpr int maxOutputChannels = 8;
+
+    // The reset and run output buses follow the clock outputs
+    static constexpr int resetBusIndex = dingus_dsp::ClockBank::numClocks;
+    static constexpr int runBusIndex = resetBusIndex + 1;
+
+    // The length of a reset trigger
+    static constexpr double resetPulseMs = 5.0;
+
+    // A reset at the start of a block and another at a loop wrap
+    static constexpr int maxResetsPerBlock = 2;
+
+    // The largest difference from the expected position that is not treated as a jump
+    static constexpr double jumpToleranceMs = 5.0;
+
+    // Choices for the align parameter.  Bar restarts the pulse grid at each bar
+    // line, Song keeps one continuous grid from the start of the song.
+    enum AlignMode
+    {
+        alignBar = 0,
+        alignSong
+    };
+
+    // Choices for the sync parameter, the timeline the clocks follow
+    enum SyncSource
+    {
+        syncHost = 0,
+        syncInput,
+        syncMidi
+    };
+
+    // The saved state starts with this tag and a format version, followed by
+    // the parameter tree in JUCE's binary value tree format.  States without
+    // the tag are read as the XML of earlier versions, states with a newer
+    // format version are not read at all.
+    static constexpr int stateChunkId = 0x4d4b4c43; // "CLKM"
+    static constexpr int stateVersion = 1;
+    static constexpr int stateHeaderSize = 8;
+
+    // Build the parameters for every clock output
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    // The ID of the named parameter for the clock at index in the bank
+    static juce::String getClockParameterId (const juce::String& name, int index);
+
     juce::AudioProcessorValueTreeState parameters;
     juce::AudioPlayHead::CurrentPositionInfo currentPositionInfo;
-    dingus_dsp::Clock dingusClock;
+    dingus_dsp::ClockBank clockBank;
+
+    // A second clock running at the MIDI clock rate, sharing the same edge computation
+    static constexpr int midiClockPpqn = 24;
+    static constexpr int maxMidiClockEvents = 256;
+    dingus_dsp::Clock midiClock;
+    std::array<dingus_dsp::Clock::Edge, maxMidiClockEvents * 2> midiClockEdges;
+    juce::MidiBuffer midiOutput;
+
+    // Whether the host's buffer holds the reserved MIDI storage from the last block
+    bool midiOutputWithHost = false;
+
+    // Song position is counted in 16th notes of 6 ticks and has 14 bits, so
+    // MIDI Start or Continue waits for the first tick on a 16th, and the ticks
+    // before it are held back
+    static constexpr int ticksPerSongPosition = 6;
+    static constexpr int maxSongPosition = 0x3FFF;
+    bool midiStartPending = false;
+
+    // Whether MIDI Start or Continue has been sent since the last Stop
+    bool midiTransportRunning = false;
+
+    // The position and samples per quarter note at the start of the MIDI
+    // clock's timeline, to find where its ticks are on the song
+    double midiClockPosition = 0.0;
+    double midiClockSamplesPerQuarter = 0.0;
+
+    dingus_dsp::Telemetry telemetry;
+
+    // Each clock output bus is one trace on the scope
+    static_assert (dingus_dsp::PulseScope::numTraces == dingus_dsp::ClockBank::numClocks, "One scope trace per clock");
+    dingus_dsp::PulseScope pulseScope;
+
+    // The scope's pulses are read from each clock's edge schedule.  Any edges
+    // past this many in a block are only left off the display.
+    static constexpr int maxScopeEdges = 1024;
+    std::array<dingus_dsp::Clock::Edge, maxScopeEdges> scopeEdges;
+
+    // Follows a clock on the main input in place of the host transport
+    static constexpr float inputHysteresis = 0.05f;
+    dingus_dsp::ClockFollower inputFollower;
+
+    // Follows incoming MIDI clock in place of the host transport.  MIDI clock is
+    // far less steady than an audio clock, so the loop smooths it harder.
+    static constexpr double midiLoopGain = 0.1;
+    static constexpr double midiLockTolerance = 0.15;
+    dingus_dsp::ClockFollower midiFollower;
+    bool midiRunning = false;
+    double midiResumePosition = 0.0;
+
+    // A start or continue only moves the follower on its next tick, so playback
+    // waits for that tick rather than running on from the old position
+    bool midiRunPending = false;
+
+    // Parameter values for one clock, published by parameterChanged and applied
+    // at the start of each block once any of them has changed.  Only the audio
+    // thread touches the clocks.
+    struct ClockParameters
+    {
+        std::atomic<int> ppqn { 24 };
+        std::atomic<int> mulDiv { 0 };
+        std::atomic<float> width { 50.f };
+        std::atomic<float> trigger { 0.f };
+        std::atomic<int> swing { 50 };
+        std::atomic<int> steps { 16 };
+        std::atomic<int> hits { 16 };
+        std::atomic<int> rotate { 0 };
+        std::atomic<bool> changed { true };
+    };
+
+    std::array<ClockParameters, dingus_dsp::ClockBank::numClocks> clockParameters;
+    std::atomic<bool> midiClockEnabled { true };
+    std::atomic<bool> bandLimitedEnabled { false };
+    std::atomic<float> offsetMs { 0.f };
+    std::atomic<int> alignMode { alignBar };
+    std::atomic<int> syncSource { syncHost };
+    std::atomic<int> inputPpqn { 24 };
+    std::atomic<float> inputThreshold { 0.25f };
+
+    // Apply the published input settings to the clock follower
+    void applyFollowerParameters();
+
+    // Apply any published parameter changes to the clocks
+    void applyClockParameters();
+
+    // Report the positive part of the output offset to the host as latency
+    void updateLatency();
+    void handleAsyncUpdate() override;
+
+    // Process a block at either precision, the clocks render straight into the buffer
+    template <typename SampleType>
+    void process (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
+
+    // Follow the transport without rendering while bypassed
+    template <typename SampleType>
+    void processBypassed (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
+
+    // Read the position of the timeline being followed into currentPositionInfo,
+    // returning whether it is playing
+    template <typename SampleType>
+    bool readTransport (juce::AudioBuffer<SampleType>& buffer, const juce::MidiBuffer& midiMessages);
+
+    // Replace the host position with the tempo and position of the input clock
+    template <typename SampleType>
+    void followInputClock (juce::AudioBuffer<SampleType>& buffer);
+
+    // Replace the host position with the tempo and position of incoming MIDI clock
+    void followMidiClock (const juce::MidiBuffer& midiMessages, int numSamples);
+
+    // Set the transport from a follower's tempo and position
+    void setFollowedPosition (const dingus_dsp::ClockFollower& follower, bool isRunning);
+
+    // Set the tempo and position of every clock for the next numSamples
+    void setTimeline (double bpm, double endBpm, double ppqPosition, int numSamples);
+
+    // Where the reset and run outputs change within a block
+    struct TransportEdges
+    {
+        std::array<int, maxResetsPerBlock> resets {};
+        int numResets = 0;
+        int runStart = 0;
+    };
+
+    // Render the clocks for part of the block from a timeline starting at
+    // ppqPosition, and note where the reset and run outputs start
+    template <typename SampleType>
+    void renderSegment (juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples, double bpm, double endBpm,
+                        double ppqPosition, double samplesPerQuarter, TransportEdges& edges);
+
+    // Render the clock outputs and MIDI clock ticks for part of the block,
+    // leaving the first mutedSamples silent
+    template <typename SampleType>
+    void renderClocks (juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples, int mutedSamples);
+
+    // Pass the range of the rendered clock outputs to the scope, when the editor
+    // has it enabled.  The pulses are passed as each clock is rendered.
+    template <typename SampleType>
+    void updatePulseScope (juce::AudioBuffer<SampleType>& buffer, double ppqPosition, double samplesPerQuarter);
+
+    // Render the reset and run outputs for the block
+    template <typename SampleType>
+    void renderTransport (juce::AudioBuffer<SampleType>& buffer, const TransportEdges& edges);
+
+    // Write MIDI stop messages for the block.  When playback starts, or moves at
+    // a locate or loop wrap, at restartSample, queue start/continue with the song
+    // position for renderClocks to send on the first tick of a 16th note.  A
+    // negative restartSample is no restart.
+    void addMidiTransportMessages (bool transportStopped, int restartSample);
+
+    // Transport state from the previous block, used to estimate tempo ramps and
+    // to detect jumps in the timeline
+    bool wasPlaying = false;
+    double lastBpm = 0.0;
+    double lastTempoSlope = 0.0;
+    int lastNumSamples = 0;
+    double expectedPpqPosition = 0.0;
+
+    // A start, stop or jump the transport made while bypassed, held until the
+    // next rendered block so the reset, run and MIDI transport still follow it
+    bool bypassedStart = false;
+    bool bypassedStop = false;
+    bool bypassedJump = false;
+
+    // The position the pulse grid is measured from for the current block
+    double gridOrigin = 0.0;
+
+    // The part of a reset trigger still to be written in the next block
+    int resetSamplesRemaining = 0;
+
+    // The position playback started from at the last start, locate or loop
+    // wrap.  A negative offset puts the clocks before it for a while, so the
+    // outputs wait until they reach it, and the reset and run outputs with them.
+    double playStartPosition = 0.0;
+    bool resetPending = false;
+    bool runStarted = false;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ClockmakerAudioProcessor)
 };
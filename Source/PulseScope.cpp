@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    File: pulsescope.cpp
+    Author: Daniel Schwartz
+    Description: Passes a decimated view of the clock outputs to the editor.
+
+  ==============================================================================
+*/
+
+#include "PulseScope.h"
+
+using namespace dingus_dsp;
+
+void PulseScope::Init(double sample_rate)
+{
+    frame_size_.store(juce::jmax(1, juce::roundToInt(sample_rate / frameRate)), std::memory_order_relaxed);
+    time_ = 0;
+    frame_fill_ = 0;
+    running_ = false;
+}
+
+template <typename SampleType>
+void PulseScope::ProcessBlock(const SampleType* const* traces, int num_samples, double ppq_position, double ppq_per_sample)
+{
+    if (!IsEnabled())
+    {
+        time_ += num_samples;
+        running_ = false;
+        return;
+    }
+
+    // After a gap the partial frame is stale, so start afresh
+    if (!running_)
+    {
+        frame_fill_ = 0;
+        running_ = true;
+    }
+
+    int frame_size = GetFrameSize();
+    int i = 0;
+
+    while (i < num_samples)
+    {
+        int count = juce::jmin(frame_size - frame_fill_, num_samples - i);
+
+        for (size_t trace = 0; trace < numTraces; ++trace)
+            AddTrace(trace, traces[trace], i, count);
+
+        frame_fill_ += count;
+        i += count;
+
+        if (frame_fill_ >= frame_size)
+        {
+            frame_.time = time_ + i;
+            frame_.ppq_position = ppq_position + i * ppq_per_sample;
+            Push(frame_fifo_, frames_, frame_);
+            frame_fill_ = 0;
+        }
+    }
+
+    time_ += num_samples;
+}
+
+template <typename SampleType>
+void PulseScope::AddTrace(size_t trace, const SampleType* in, int index, int count)
+{
+    SampleType minimum = 0;
+    SampleType maximum = 0;
+
+    if (in != nullptr)
+        juce::FloatVectorOperations::findMinAndMax(in + index, count, minimum, maximum);
+
+    if (frame_fill_ == 0)
+    {
+        frame_.minimum[trace] = static_cast<float>(minimum);
+        frame_.maximum[trace] = static_cast<float>(maximum);
+    }
+    else
+    {
+        frame_.minimum[trace] = juce::jmin(frame_.minimum[trace], static_cast<float>(minimum));
+        frame_.maximum[trace] = juce::jmax(frame_.maximum[trace], static_cast<float>(maximum));
+    }
+}
+
+void PulseScope::AddEdge(int trace, double sample_offset)
+{
+    if (IsEnabled())
+        Push(edge_fifo_, edges_, Edge{ static_cast<double>(time_) + sample_offset, trace });
+}
+
+int PulseScope::ReadFrames(Frame* dest, int max_frames)
+{
+    return Pop(frame_fifo_, frames_, dest, max_frames);
+}
+
+int PulseScope::ReadEdges(Edge* dest, int max_edges)
+{
+    return Pop(edge_fifo_, edges_, dest, max_edges);
+}
+
+template void PulseScope::ProcessBlock<float>(const float* const* traces, int num_samples, double ppq_position, double ppq_per_sample);
+template void PulseScope::ProcessBlock<double>(const double* const* traces, int num_samples, double ppq_position, double ppq_per_sample);
\ No newline at end of file
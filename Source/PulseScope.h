@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+
+    File: pulsescope.h
+    Author: Daniel Schwartz
+    Description: Passes a decimated view of the clock outputs to the editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+#ifndef DINGUS_PULSESCOPE_H
+#define DINGUS_PULSESCOPE_H
+
+#include <JuceHeader.h>
+
+namespace dingus_dsp
+{
+    // Passes a decimated view of the clock outputs to the editor.
+    // The audio thread reduces each trace to the minimum and maximum of every
+    // frame of samples, takes the exact time of every rising edge from the
+    // clocks' edge schedules, and pushes both into fixed size single producer,
+    // single consumer FIFOs.
+    // Nothing is allocated or locked, a full FIFO drops the newest data, and
+    // while no reader is enabled the audio thread does no work at all.
+    class PulseScope
+    {
+    public:
+        // The number of traces in each frame.
+        static constexpr int numTraces = 4;
+
+        // The number of frames per second of audio.
+        static constexpr double frameRate = 200.0;
+
+        // The capacity of each FIFO.
+        static constexpr int maxFrames = 1024;
+        static constexpr int maxEdges = 4096;
+
+        // The range of each trace over one frame.
+        struct Frame
+        {
+            // The sample count at the end of the frame.
+            juce::int64 time;
+
+            // The position in quarter notes at the end of the frame.
+            double ppq_position;
+
+            std::array<float, numTraces> minimum;
+            std::array<float, numTraces> maximum;
+        };
+
+        // The rising edge of a pulse on one trace.
+        struct Edge
+        {
+            // The sample count at the edge, including the fraction of a sample.
+            double time;
+
+            int trace;
+        };
+
+        PulseScope() {}
+        ~PulseScope() {}
+
+        // Initialize the scope given the audio rate.
+        void Init(double sample_rate);
+
+        // Start or stop passing data to a reader.  Only the reader should call
+        // this, and the FIFOs keep any data already written.
+        void SetEnabled(bool enabled)
+        {
+            enabled_.store(enabled, std::memory_order_relaxed);
+        }
+
+        bool IsEnabled() const
+        {
+            return enabled_.load(std::memory_order_relaxed);
+        }
+
+        // Add a block of num_samples float or double samples from every trace,
+        // a null trace is silence.  The position advances by ppq_per_sample
+        // from ppq_position at the start of the block.  Only the audio thread
+        // should call this.
+        template <typename SampleType>
+        void ProcessBlock(const SampleType* const* traces, int num_samples, double ppq_position, double ppq_per_sample);
+
+        // Add a rising edge on one trace sample_offset samples, which may be
+        // fractional, after the start of the next block passed to ProcessBlock.
+        // Only the audio thread should call this.
+        void AddEdge(int trace, double sample_offset);
+
+        // Copy up to max_frames of the oldest frames to dest, returning the
+        // number copied.  Only the reader should call this.
+        int ReadFrames(Frame* dest, int max_frames);
+
+        // Copy up to max_edges of the oldest edges to dest, returning the
+        // number copied.  Only the reader should call this.
+        int ReadEdges(Edge* dest, int max_edges);
+
+        // The number of samples in a frame.
+        int GetFrameSize() const
+        {
+            return frame_size_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<bool> enabled_{ false };
+
+        std::atomic<int> frame_size_{ 1 };
+
+        // The number of samples added since the scope was initialized.
+        juce::int64 time_{};
+
+        // Whether the last block was passed to the reader.
+        bool running_{ false };
+
+        // The frame being filled, and how many samples it holds.
+        Frame frame_{};
+        int frame_fill_{};
+
+        juce::AbstractFifo frame_fifo_{ maxFrames };
+        std::array<Frame, maxFrames> frames_;
+
+        juce::AbstractFifo edge_fifo_{ maxEdges };
+        std::array<Edge, maxEdges> edges_;
+
+        // Reduce count samples of one trace starting at index into the frame.
+        template <typename SampleType>
+        void AddTrace(size_t trace, const SampleType* in, int index, int count);
+
+        // Write one item to a FIFO, dropping it if the FIFO is full.
+        template <typename Item, size_t Size>
+        static void Push(juce::AbstractFifo& fifo, std::array<Item, Size>& items, const Item& item)
+        {
+            int start1, size1, start2, size2;
+            fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+            if (size1 > 0)
+                items[static_cast<size_t>(start1)] = item;
+
+            fifo.finishedWrite(size1);
+        }
+
+        // Read up to max_items from a FIFO into dest.
+        template <typename Item, size_t Size>
+        static int Pop(juce::AbstractFifo& fifo, const std::array<Item, Size>& items, Item* dest, int max_items)
+        {
+            int start1, size1, start2, size2;
+            fifo.prepareToRead(max_items, start1, size1, start2, size2);
+
+            std::copy_n(items.begin() + start1, size1, dest);
+            std::copy_n(items.begin() + start2, size2, dest + size1);
+
+            fifo.finishedRead(size1 + size2);
+            return size1 + size2;
+        }
+    };
+}
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    File: realtimecheck.cpp
+    Author: Daniel Schwartz
+    Description: Checks that the audio callback stays real-time safe.
+
+  ==============================================================================
+*/
+
+#include "RealtimeCheck.h"
+
+#if CLOCKMAKER_REALTIME_CHECKS
+
+#include <cstdlib>
+#include <new>
+
+using namespace dingus_dsp;
+
+namespace
+{
+    // How deeply the current thread is nested in the audio callback
+    thread_local int realtimeDepth = 0;
+
+    std::atomic<int> violationCount { 0 };
+
+    void checkRealtime()
+    {
+        if (realtimeDepth <= 0)
+            return;
+
+        ++violationCount;
+
+        // The assertion may log, which allocates, so leave the callback while
+        // reporting to avoid counting that too
+        int depth = realtimeDepth;
+        realtimeDepth = 0;
+        jassertfalse;
+        realtimeDepth = depth;
+    }
+
+    void* allocate(std::size_t size)
+    {
+        checkRealtime();
+        return std::malloc(size > 0 ? size : 1);
+    }
+
+    void deallocate(void* ptr)
+    {
+        if (ptr != nullptr)
+            checkRealtime();
+
+        std::free(ptr);
+    }
+}
+
+void RealtimeCheck::Enter()
+{
+    ++realtimeDepth;
+}
+
+void RealtimeCheck::Exit()
+{
+    --realtimeDepth;
+}
+
+void RealtimeCheck::AssertNotRealtime()
+{
+    checkRealtime();
+}
+
+int RealtimeCheck::GetViolationCount()
+{
+    return violationCount.load();
+}
+
+//==============================================================================
+// Replacing the global allocation functions catches allocations from JUCE and
+// the standard library as well as our own code.  Over-aligned allocations keep
+// the default functions and are not checked.
+void* operator new(std::size_t size)
+{
+    if (void* ptr = allocate(size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    deallocate(ptr);
+}
+
+#endif
\ No newline at end of file
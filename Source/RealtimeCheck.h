@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    File: realtimecheck.h
+    Author: Daniel Schwartz
+    Description: Checks that the audio callback stays real-time safe.
+
+  ==============================================================================
+*/
+
+#pragma once
+#ifndef DINGUS_REALTIMECHECK_H
+#define DINGUS_REALTIMECHECK_H
+
+#include <JuceHeader.h>
+
+// Set to 1 to check that nothing allocates, frees or blocks while the audio
+// callback is running.  The Debug configuration turns this on.
+#ifndef CLOCKMAKER_REALTIME_CHECKS
+ #define CLOCKMAKER_REALTIME_CHECKS 0
+#endif
+
+namespace dingus_dsp
+{
+    // Checks that the audio callback stays real-time safe.
+    // While a thread is marked as running the audio callback, any call to the
+    // global operator new or delete, or to code marked as blocking, counts as a
+    // violation and hits an assertion.  On Linux the offline harness also sends
+    // locks, waits, sleeps and writes through AssertNotRealtime.  Everything
+    // compiles away when CLOCKMAKER_REALTIME_CHECKS is 0.
+    class RealtimeCheck
+    {
+    public:
+        // Marks the current thread as running the audio callback while in scope.
+        struct ScopedRealtime
+        {
+            ScopedRealtime() { Enter(); }
+            ~ScopedRealtime() { Exit(); }
+        };
+
+       #if CLOCKMAKER_REALTIME_CHECKS
+        // Mark the start and end of the audio callback on the current thread.
+        static void Enter();
+        static void Exit();
+
+        // Report a violation if the current thread is running the audio callback.
+        // Call this from anything that may allocate, lock or wait.
+        static void AssertNotRealtime();
+
+        // The number of violations since the plugin was loaded.
+        static int GetViolationCount();
+       #else
+        static void Enter() {}
+        static void Exit() {}
+        static void AssertNotRealtime() {}
+        static int GetViolationCount() { return 0; }
+       #endif
+    };
+}
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    ScopeView.cpp
+    Created: 17 Oct 2026 10:12:40am
+    Author:  Daniel Schwartz
+
+  ==============================================================================
+*/
+
+#include "ScopeView.h"
+
+using namespace dingus_dsp;
+using namespace juce;
+
+//===================================================================================
+ScopeView::ScopeView(PulseScope& pulseScope) : scope(pulseScope)
+{
+    setOpaque(true);
+    scope.SetEnabled(true);
+    startTimerHz(maxRefreshRate);
+}
+
+ScopeView::~ScopeView()
+{
+    scope.SetEnabled(false);
+}
+
+//===================================================================================
+// copy everything new from the scope straight into the rings
+void ScopeView::timerCallback()
+{
+    bool changed = false;
+
+    for (int count; (count = scope.ReadFrames(frames.data() + nextFrame, historyFrames - nextFrame)) > 0;)
+    {
+        nextFrame = (nextFrame + count) % historyFrames;
+        numFrames = jmin(numFrames + count, historyFrames);
+        changed = true;
+    }
+
+    for (int count; (count = scope.ReadEdges(edges.data() + nextEdge, historyEdges - nextEdge)) > 0;)
+    {
+        nextEdge = (nextEdge + count) % historyEdges;
+        numEdges = jmin(numEdges + count, historyEdges);
+        changed = true;
+    }
+
+    if (changed)
+        repaint();
+}
+
+//===================================================================================
+// each clock has a lane, drawn as the range of its output over each frame with
+// a tick at each rising edge, and the beat lines run across every lane
+void ScopeView::paint(Graphics& g)
+{
+    g.fillAll(findColour(ResizableWindow::backgroundColourId).brighter(0.1f));
+
+    if (numFrames == 0)
+        return;
+
+    Rectangle<float> bounds = getLocalBounds().toFloat();
+    float frameWidth = bounds.getWidth() / historyFrames;
+    float laneHeight = bounds.getHeight() / PulseScope::numTraces;
+    float samplesPerFrame = (float)scope.GetFrameSize();
+
+    // the newest frame ends at the right hand edge
+    int64 newestTime = frames[(size_t)((nextFrame + historyFrames - 1) % historyFrames)].time;
+
+    auto getX = [&](double time)
+    {
+        return bounds.getRight() - (float)((double)newestTime - time) / samplesPerFrame * frameWidth;
+    };
+
+    auto getY = [&](int trace, float level)
+    {
+        // the clocks swing from -1 to 1
+        float height = jlimit(0.0f, 1.0f, 0.5f * (level + 1.0f));
+        return bounds.getY() + laneHeight * (trace + 1) - 2.0f - height * (laneHeight - 6.0f);
+    };
+
+    Colour gridColour = findColour(Slider::rotarySliderOutlineColourId);
+    Colour traceColour = findColour(Slider::rotarySliderFillColourId);
+    Colour edgeColour = findColour(Slider::thumbColourId);
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        const PulseScope::Frame& frame = frames[(size_t)((nextFrame + historyFrames - numFrames + i) % historyFrames)];
+        float x = getX((double)frame.time);
+
+        if (i > 0)
+        {
+            const PulseScope::Frame& last = frames[(size_t)((nextFrame + historyFrames - numFrames + i - 1) % historyFrames)];
+
+            if (std::floor(frame.ppq_position) != std::floor(last.ppq_position))
+            {
+                g.setColour(gridColour);
+                g.drawVerticalLine(roundToInt(x), bounds.getY(), bounds.getBottom());
+            }
+        }
+
+        g.setColour(traceColour);
+
+        for (int trace = 0; trace < PulseScope::numTraces; ++trace)
+        {
+            float top = getY(trace, frame.maximum[(size_t)trace]);
+            float bottom = getY(trace, frame.minimum[(size_t)trace]);
+            g.fillRect(x - frameWidth, top, frameWidth, jmax(1.0f, bottom - top));
+        }
+    }
+
+    g.setColour(edgeColour);
+
+    for (int i = 0; i < numEdges; ++i)
+    {
+        const PulseScope::Edge& edge = edges[(size_t)((nextEdge + historyEdges - numEdges + i) % historyEdges)];
+        float x = getX(edge.time);
+
+        if (x >= bounds.getX() && x <= bounds.getRight())
+        {
+            float top = getY(edge.trace, 1.0f);
+            g.fillRect(x - 0.5f, top - 2.0f, 1.0f, 4.0f);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    ScopeView.h
+    Created: 17 Oct 2026 10:12:40am
+    Author:  Daniel Schwartz
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PulseScope.h"
+
+namespace dingus_dsp
+{
+    //===================================================================================
+    // shows the recent pulses of every clock against the beat grid
+    class ScopeView : public juce::Component, private juce::Timer
+    {
+    public:
+        // the scope is enabled for as long as the view exists
+        ScopeView(PulseScope& pulseScope);
+        ~ScopeView() override;
+
+        void paint(juce::Graphics& g) override;
+
+    private:
+        void timerCallback() override;
+
+        PulseScope& scope;
+
+        // the most repaints per second, which only happen when new frames arrive
+        static constexpr int maxRefreshRate = 30;
+
+        // the frames and edges shown, newest last, kept in rings so reading
+        // from the scope never allocates
+        static constexpr int historyFrames = 400;
+        std::array<PulseScope::Frame, historyFrames> frames;
+        int nextFrame = 0;
+        int numFrames = 0;
+
+        static constexpr int historyEdges = 1024;
+        std::array<PulseScope::Edge, historyEdges> edges;
+        int nextEdge = 0;
+        int numEdges = 0;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScopeView)
+    };
+}
\ No newline at end of file
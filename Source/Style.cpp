@@ -136,12 +136,12 @@ void Style::drawRotarySlider(Graphics& g, int x, int y, int width, int height, f
     float angle = rotaryStartAngle + sliderPos * (rotaryEndAngle - rotaryStartAngle);
     float arcRadius = radius - trackWidth * 0.5f;
 
-    Path backgroundArc;
-    backgroundArc.addCentredArc(bounds.getCentreX(), bounds.getCentreY(), arcRadius, arcRadius,
-        0.0f, rotaryStartAngle, rotaryEndAngle, true);
+    // the track is drawn from a cached image at the display's pixel scale
+    float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    const Image& track = getRotaryTrack(width, height, scale, rotaryStartAngle, rotaryEndAngle,
+        slider.findColour(Slider::rotarySliderOutlineColourId));
 
-    g.setColour(slider.findColour(Slider::rotarySliderOutlineColourId));
-    g.strokePath(backgroundArc, PathStrokeType(trackWidth, PathStrokeType::curved, PathStrokeType::square));
+    g.drawImageTransformed(track, AffineTransform::scale(1.0f / scale).translated((float)x, (float)y));
 
 
     Path valueArc;
@@ -159,8 +159,43 @@ void Style::drawRotarySlider(Graphics& g, int x, int y, int width, int height, f
     g.fillPath(thumb);
 }
 
+// Finds or draws the background arc for a rotary slider of this size
+const Image& Style::getRotaryTrack(int width, int height, float scale,
+    float rotaryStartAngle, float rotaryEndAngle, Colour colour)
+{
+    for (auto& track : rotaryTracks)
+    {
+        if (track.width == width && track.height == height && track.scale == scale
+            && track.startAngle == rotaryStartAngle && track.endAngle == rotaryEndAngle && track.colour == colour)
+            return track.image;
+    }
+
+    Rectangle<float> bounds = Rectangle<int>(width, height).toFloat().reduced(10);
+    float radius = jmin(bounds.getWidth(), bounds.getHeight()) / 2.0f;
+    float arcRadius = radius - trackWidth * 0.5f;
+
+    Image image(Image::ARGB, jmax(1, roundToInt(width * scale)), jmax(1, roundToInt(height * scale)), true);
+    Graphics g(image);
+    g.addTransform(AffineTransform::scale(scale));
+
+    Path backgroundArc;
+    backgroundArc.addCentredArc(bounds.getCentreX(), bounds.getCentreY(), arcRadius, arcRadius,
+        0.0f, rotaryStartAngle, rotaryEndAngle, true);
+
+    g.setColour(colour);
+    g.strokePath(backgroundArc, PathStrokeType(trackWidth, PathStrokeType::curved, PathStrokeType::square));
+
+    // the editor only has a few sizes of slider, so the oldest track is dropped
+    // if the cache fills up after a lot of resizing
+    if (rotaryTracks.size() >= maxRotaryTracks)
+        rotaryTracks.remove(0);
+
+    rotaryTracks.add({ width, height, scale, rotaryStartAngle, rotaryEndAngle, colour, image });
+    return rotaryTracks.getReference(rotaryTracks.size() - 1).image;
+}
+
 // This implementation provides custom textbox locations
-Slider::SliderLayout Style::getSliderLayout(Slider& slider) 
+Slider::SliderLayout Style::getSliderLayout(Slider& /*slider*/) 
 {
     Slider::SliderLayout layout;
 
@@ -83,6 +83,25 @@ namespace dingus_dsp
         const float thumbWidth = 18.0f;
         const float thumbHeight = 6.0f;
 
+        // rotary tracks only change with size, scale or colour, so each one is
+        // drawn once into an image and reused on every repaint
+        struct RotaryTrack
+        {
+            int width;
+            int height;
+            float scale;
+            float startAngle;
+            float endAngle;
+            juce::Colour colour;
+            juce::Image image;
+        };
+
+        juce::Array<RotaryTrack> rotaryTracks;
+        static constexpr int maxRotaryTracks = 8;
+
+        const juce::Image& getRotaryTrack(int width, int height, float scale,
+            float rotaryStartAngle, float rotaryEndAngle, juce::Colour colour);
+
     };
     //===================================================================================
 }
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    File: telemetry.cpp
+    Author: Daniel Schwartz
+    Description: Lock-free statistics on the cost and accuracy of each block.
+
+  ==============================================================================
+*/
+
+#include "Telemetry.h"
+
+using namespace dingus_dsp;
+
+namespace
+{
+    // The value at the top of a bin
+    double binTop(double min_value, int bin)
+    {
+        return min_value * std::exp2((bin + 1) / static_cast<double>(Telemetry::binsPerOctave));
+    }
+}
+
+Telemetry::Telemetry()
+{
+    // Block times from 1 us, timeline and edge errors from 1/256 of a sample,
+    // each covering 16 octaves
+    block_time_.min_value = 1.0;
+    timeline_error_.min_value = 1.0 / 256.0;
+    edge_error_.min_value = 1.0 / 256.0;
+
+    for (auto* histogram : { &block_time_, &timeline_error_, &edge_error_ })
+    {
+        for (auto& count : histogram->counts)
+            count.store(0, std::memory_order_relaxed);
+    }
+}
+
+Telemetry::Snapshot Telemetry::GetSnapshot() const
+{
+    Snapshot snapshot;
+    block_time_.CopyTo(snapshot.block_time);
+    timeline_error_.CopyTo(snapshot.timeline_error);
+    edge_error_.CopyTo(snapshot.edge_error);
+    return snapshot;
+}
+
+void Telemetry::AtomicHistogram::Add(double value)
+{
+    // Values below the first bin are counted in it, values above the last in that
+    int bin = 0;
+
+    if (value > min_value)
+        bin = juce::jmin(numBins - 1, static_cast<int>(std::log2(value / min_value) * binsPerOctave));
+
+    counts[static_cast<size_t>(bin)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Telemetry::AtomicHistogram::CopyTo(Histogram& histogram) const
+{
+    histogram.min_value = min_value;
+
+    for (size_t i = 0; i < numBins; ++i)
+        histogram.counts[i] = counts[i].load(std::memory_order_relaxed);
+}
+
+juce::uint64 Telemetry::Histogram::GetTotal() const
+{
+    juce::uint64 total = 0;
+
+    for (auto count : counts)
+        total += count;
+
+    return total;
+}
+
+double Telemetry::Histogram::GetPercentile(double p) const
+{
+    auto total = GetTotal();
+
+    if (total == 0)
+        return 0.0;
+
+    auto target = static_cast<juce::uint64>(std::ceil(p * total));
+    juce::uint64 sum = 0;
+
+    for (size_t i = 0; i < numBins; ++i)
+    {
+        sum += counts[i];
+
+        if (sum >= target && sum > 0)
+            return binTop(min_value, static_cast<int>(i));
+    }
+
+    return binTop(min_value, numBins - 1);
+}
+
+Telemetry::Histogram Telemetry::Histogram::Since(const Histogram& earlier) const
+{
+    // The counters only increase, so unsigned wrap around still gives the difference
+    Histogram difference;
+    difference.min_value = min_value;
+
+    for (size_t i = 0; i < numBins; ++i)
+        difference.counts[i] = counts[i] - earlier.counts[i];
+
+    return difference;
+}
+
+Telemetry::Snapshot Telemetry::Snapshot::Since(const Snapshot& earlier) const
+{
+    Snapshot difference;
+    difference.block_time = block_time.Since(earlier.block_time);
+    difference.timeline_error = timeline_error.Since(earlier.timeline_error);
+    difference.edge_error = edge_error.Since(earlier.edge_error);
+    return difference;
+}
+
+juce::String Telemetry::Snapshot::ToString() const
+{
+    return "blocks " + juce::String(static_cast<juce::int64>(block_time.GetTotal()))
+         + ", time p50 " + juce::String(block_time.GetPercentile(0.5), 1) + " us"
+         + " p99 " + juce::String(block_time.GetPercentile(0.99), 1) + " us"
+         + ", timeline error p50 " + juce::String(timeline_error.GetPercentile(0.5), 3)
+         + " p99 " + juce::String(timeline_error.GetPercentile(0.99), 3) + " samples"
+         + ", edges " + juce::String(static_cast<juce::int64>(edge_error.GetTotal()))
+         + ", edge error p50 " + juce::String(edge_error.GetPercentile(0.5), 3)
+         + " p99 " + juce::String(edge_error.GetPercentile(0.99), 3) + " samples";
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    File: telemetry.h
+    Author: Daniel Schwartz
+    Description: Lock-free statistics on the cost and accuracy of each block.
+
+  ==============================================================================
+*/
+
+#pragma once
+#ifndef DINGUS_TELEMETRY_H
+#define DINGUS_TELEMETRY_H
+
+#include <JuceHeader.h>
+
+namespace dingus_dsp
+{
+    // Lock-free statistics on the cost and accuracy of each block.
+    // The audio thread adds values per block or per edge to fixed histograms of
+    // atomic counters, which never allocates or waits.  Any other thread can copy the
+    // counts into a snapshot, and the difference between two snapshots gives
+    // the statistics for the blocks in between.
+    class Telemetry
+    {
+    public:
+        // Histogram bins are spaced logarithmically, a quarter octave apart.
+        static constexpr int numBins = 64;
+        static constexpr int binsPerOctave = 4;
+
+        // A copy of the counts in one histogram.
+        struct Histogram
+        {
+            std::array<juce::uint32, numBins> counts{};
+            double min_value{};
+
+            // The number of values counted.
+            juce::uint64 GetTotal() const;
+
+            // The value below which the fraction p of the values fall, rounded
+            // up to the top of its bin.
+            double GetPercentile(double p) const;
+
+            // The counts added since an earlier copy of the same histogram.
+            Histogram Since(const Histogram& earlier) const;
+        };
+
+        // A copy of every histogram.
+        struct Snapshot
+        {
+            // Processing time per block in microseconds.
+            Histogram block_time;
+
+            // The distance in samples between where a block started and where
+            // the previous block predicted it would start.
+            Histogram timeline_error;
+
+            // The distance in samples from the exact, fractional time of each
+            // rendered edge to the sample it was placed on.
+            Histogram edge_error;
+
+            // The statistics added since an earlier snapshot.
+            Snapshot Since(const Snapshot& earlier) const;
+
+            // A one line summary for logging.
+            juce::String ToString() const;
+        };
+
+        // Times the current block for as long as it is in scope.
+        class ScopedBlockTimer
+        {
+        public:
+            explicit ScopedBlockTimer(Telemetry& telemetry)
+                : telemetry_(telemetry), start_(juce::Time::getHighResolutionTicks())
+            {
+            }
+
+            ~ScopedBlockTimer()
+            {
+                auto ticks = juce::Time::getHighResolutionTicks() - start_;
+                telemetry_.AddBlockTime(juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6);
+            }
+
+        private:
+            Telemetry& telemetry_;
+            juce::int64 start_;
+        };
+
+        Telemetry();
+        ~Telemetry() {}
+
+        // Add the processing time of a block in microseconds.
+        void AddBlockTime(double microseconds)
+        {
+            block_time_.Add(microseconds);
+        }
+
+        // Add the timeline error at the start of a block in samples.
+        void AddTimelineError(double samples)
+        {
+            timeline_error_.Add(samples);
+        }
+
+        // Add the error of one rendered edge in samples.
+        void AddEdgeError(double samples)
+        {
+            edge_error_.Add(samples);
+        }
+
+        // Copy the current counts.
+        Snapshot GetSnapshot() const;
+
+    private:
+        struct AtomicHistogram
+        {
+            std::array<std::atomic<juce::uint32>, numBins> counts;
+            double min_value{};
+
+            void Add(double value);
+            void CopyTo(Histogram& histogram) const;
+        };
+
+        AtomicHistogram block_time_;
+        AtomicHistogram timeline_error_;
+        AtomicHistogram edge_error_;
+
+        JUCE_DECLARE_NON_COPYABLE(Telemetry)
+    };
+}
+
+
+#endif
\ No newline at end of file